@@ -46,6 +46,21 @@ COROUTINE(counterB) {
   }
 }
 
+// The same 2 coroutines without virtual methods.
+CRTP_COROUTINE(crtpCounterA) {
+  COROUTINE_LOOP() {
+    counter++;
+    COROUTINE_YIELD();
+  }
+}
+
+CRTP_COROUTINE(crtpCounterB) {
+  COROUTINE_LOOP() {
+    counter++;
+    COROUTINE_YIELD();
+  }
+}
+
 void checkEqual(
     const __FlashStringHelper* msg, uint32_t expected, uint32_t observed) {
   if (expected != observed) {
@@ -119,6 +134,80 @@ uint32_t doCoroutineScheduling(uint32_t iterations) {
   return end - start;
 }
 
+uint32_t doCoroutineSchedulingRunPass(uint32_t iterations) {
+  yield();
+  counter = 0;
+  uint32_t start = millis();
+
+  // Run for 1/2 as many iterations because each pass runs 2 coroutines.
+  for (uint32_t i = 0; i < iterations / 2; i++) {
+    CoroutineScheduler::runPass();
+  }
+  uint32_t end = millis();
+  yield();
+  checkEqual(F("doCoroutineSchedulingRunPass()"), counter, iterations);
+  return end - start;
+}
+
+uint32_t doCoroutineSchedulingRunFor(uint32_t iterations) {
+  yield();
+  counter = 0;
+  uint32_t start = millis();
+  while (counter < iterations) {
+    CoroutineScheduler::runFor(1000);
+  }
+  uint32_t end = millis();
+  yield();
+
+  // The last runFor() overshoots, so scale the elapsed time to 'iterations'.
+  // Use 64 bits so that the product does not overflow. The 'counter' is 0
+  // only if 'iterations' is 0.
+  if (counter == 0) return 0;
+  return (uint32_t) ((uint64_t) (end - start) * iterations / counter);
+}
+
+// The same 2 coroutines, in a table fixed at compile time.
+using StaticScheduler = StaticCoroutineScheduler<
+    STATIC_COROUTINE(counterA),
+    STATIC_COROUTINE(counterB)
+>;
+
+uint32_t doStaticScheduling(uint32_t iterations) {
+  yield();
+  counter = 0;
+  uint32_t start = millis();
+
+  // Run for 1/2 as many iterations because each loop runs 2 coroutines.
+  for (uint32_t i = 0; i < iterations / 2; i++) {
+    StaticScheduler::loop();
+  }
+  uint32_t end = millis();
+  yield();
+  checkEqual(F("doStaticScheduling()"), counter, iterations);
+  return end - start;
+}
+
+// The 2 CRTP coroutines, in a table fixed at compile time.
+using CrtpScheduler = StaticCoroutineScheduler<
+    STATIC_COROUTINE(crtpCounterA),
+    STATIC_COROUTINE(crtpCounterB)
+>;
+
+uint32_t doCrtpScheduling(uint32_t iterations) {
+  yield();
+  counter = 0;
+  uint32_t start = millis();
+
+  // Run for 1/2 as many iterations because each loop runs 2 coroutines.
+  for (uint32_t i = 0; i < iterations / 2; i++) {
+    CrtpScheduler::loop();
+  }
+  uint32_t end = millis();
+  yield();
+  checkEqual(F("doCrtpScheduling()"), counter, iterations);
+  return end - start;
+}
+
 uint32_t doCoroutineSchedulingWithProfiler(uint32_t iterations) {
   yield();
   counter = 0;
@@ -191,11 +280,23 @@ void setup() {
   uint32_t schedulerMillis = doCoroutineScheduling(NUM_ITERATIONS);
   printStats(F("CoroutineScheduling"), schedulerMillis, NUM_ITERATIONS);
 
+  uint32_t runPassMillis = doCoroutineSchedulingRunPass(NUM_ITERATIONS);
+  printStats(F("CoroutineSchedulingRunPass"), runPassMillis, NUM_ITERATIONS);
+
+  uint32_t runForMillis = doCoroutineSchedulingRunFor(NUM_ITERATIONS);
+  printStats(F("CoroutineSchedulingRunFor"), runForMillis, NUM_ITERATIONS);
+
   uint32_t schedulerMillisWithProfiler =
       doCoroutineSchedulingWithProfiler(NUM_ITERATIONS);
   printStats(F("CoroutineSchedulingWithProfiler"),
       schedulerMillisWithProfiler, NUM_ITERATIONS);
 
+  uint32_t staticMillis = doStaticScheduling(NUM_ITERATIONS);
+  printStats(F("StaticScheduling"), staticMillis, NUM_ITERATIONS);
+
+  uint32_t crtpMillis = doCrtpScheduling(NUM_ITERATIONS);
+  printStats(F("CrtpScheduling"), crtpMillis, NUM_ITERATIONS);
+
   SERIAL_PORT_MONITOR.println(F("END"));
 
 #if defined(EPOXY_DUINO)
@@ -66,6 +66,7 @@ END {
     if (name ~ /^EmptyLoop$/ \
         || name ~ /^DirectScheduling$/ \
         || name ~ /^CoroutineScheduling$/ \
+        || name ~ /^StaticScheduling$/ \
     ) {
       printf("|---------------------------------+--------+-------------+--------|\n")
     }
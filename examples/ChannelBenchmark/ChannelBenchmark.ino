@@ -12,6 +12,21 @@
  * programming, the yield() call cause additional latency of a Channel because
  * the synchronization provided by the Channel causes additional loops through
  * the Coroutine::loop() method, which causes additional calls to yield().
+ *
+ * The "Buffered" benchmark replaces the Channel with a BufferedChannel. The
+ * writer fills the buffer in a burst, and the reader drains it, so that many
+ * integers are transferred on each pass of the scheduler. The number of
+ * integers transferred is printed in the last 2 columns.
+ *
+ * The "Channels64", "Buffered64" and "ZeroCopy64" benchmarks transfer a
+ * 64-byte Frame instead of an integer, using a Channel, a BufferedChannel
+ * with write() and read(), and a BufferedChannel with reserve()/commit() and
+ * peek()/release() which does not copy the Frame.
+ *
+ * On a Linux host, a 64-byte copy is too fast to be measured, so the
+ * "Buffered1K" and "ZeroCopy1K" benchmarks repeat the last 2 with a 1024-byte
+ * BigFrame. They are not compiled on the microcontrollers, which do not have
+ * the RAM for the buffer.
  */
 
 #include <stdint.h> // uint32_t
@@ -99,15 +114,202 @@ class ReadCoroutine: public Coroutine {
 
 ReadCoroutine readCoroutine(channel);
 
+const uint8_t BUFFER_SIZE = 16;
+BufferedChannel<uint32_t, BUFFER_SIZE> bufferedChannel;
+
+// Writes to the BufferedChannel until it is full, then yields.
+COROUTINE(bufferedWriteCoroutine) {
+  COROUTINE_LOOP() {
+    while (bufferedChannel.write(writeCounter + 1)) {
+      writeCounter++;
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+// Reads from the BufferedChannel until it is empty, then yields.
+COROUTINE(bufferedReadCoroutine) {
+  COROUTINE_LOOP() {
+    uint32_t payload;
+    while (bufferedChannel.read(payload)) {
+      readCounter++;
+      readPayload = payload;
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+// A large message, e.g. a frame of sensor readings.
+struct Frame {
+  uint32_t sequence;
+  uint8_t data[60];
+};
+
+Channel<Frame> frameChannel;
+
+// Writes a Frame to the Channel, which copies it twice.
+COROUTINE(frameWriteCoroutine) {
+  static Frame frame;
+  COROUTINE_LOOP() {
+    writeCounter++;
+    frame.sequence = writeCounter;
+    COROUTINE_CHANNEL_WRITE(frameChannel, frame);
+  }
+}
+
+// Reads a Frame from the Channel, which copies it once more.
+COROUTINE(frameReadCoroutine) {
+  static Frame frame;
+  COROUTINE_LOOP() {
+    readCounter++;
+    COROUTINE_CHANNEL_READ(frameChannel, frame);
+    readPayload = frame.sequence;
+  }
+}
+
+const uint8_t FRAME_BUFFER_SIZE = 4;
+BufferedChannel<Frame, FRAME_BUFFER_SIZE> bufferedFrameChannel;
+
+// Writes Frames to the BufferedChannel until it is full, copying each one.
+COROUTINE(bufferedFrameWriteCoroutine) {
+  static Frame frame;
+  COROUTINE_LOOP() {
+    while (! bufferedFrameChannel.isFull()) {
+      writeCounter++;
+      frame.sequence = writeCounter;
+      bufferedFrameChannel.write(frame);
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+// Reads Frames from the BufferedChannel until it is empty, copying each one.
+COROUTINE(bufferedFrameReadCoroutine) {
+  static Frame frame;
+  COROUTINE_LOOP() {
+    while (bufferedFrameChannel.read(frame)) {
+      readCounter++;
+      readPayload = frame.sequence;
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+// Fills the free slots of the BufferedChannel in place.
+COROUTINE(zeroCopyWriteCoroutine) {
+  COROUTINE_LOOP() {
+    Frame* frame;
+    while ((frame = bufferedFrameChannel.reserve()) != nullptr) {
+      writeCounter++;
+      frame->sequence = writeCounter;
+      bufferedFrameChannel.commit();
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+// Reads the Frames of the BufferedChannel in place.
+COROUTINE(zeroCopyReadCoroutine) {
+  COROUTINE_LOOP() {
+    const Frame* frame;
+    while ((frame = bufferedFrameChannel.peek()) != nullptr) {
+      readCounter++;
+      readPayload = frame->sequence;
+      bufferedFrameChannel.release();
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+#if defined(EPOXY_DUINO)
+
+// A frame too large for the RAM of a microcontroller.
+struct BigFrame {
+  uint32_t sequence;
+  uint8_t data[1020];
+};
+
+BufferedChannel<BigFrame, FRAME_BUFFER_SIZE> bigFrameChannel;
+
+// Writes BigFrames to the BufferedChannel until it is full, copying each one.
+COROUTINE(bufferedBigFrameWriteCoroutine) {
+  static BigFrame frame;
+  COROUTINE_LOOP() {
+    while (! bigFrameChannel.isFull()) {
+      writeCounter++;
+      frame.sequence = writeCounter;
+      bigFrameChannel.write(frame);
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+// Reads BigFrames from the BufferedChannel until it is empty, copying each
+// one.
+COROUTINE(bufferedBigFrameReadCoroutine) {
+  static BigFrame frame;
+  COROUTINE_LOOP() {
+    while (bigFrameChannel.read(frame)) {
+      readCounter++;
+      readPayload = frame.sequence;
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+// Fills the free slots of the BufferedChannel of BigFrames in place.
+COROUTINE(zeroCopyBigWriteCoroutine) {
+  COROUTINE_LOOP() {
+    BigFrame* frame;
+    while ((frame = bigFrameChannel.reserve()) != nullptr) {
+      writeCounter++;
+      frame->sequence = writeCounter;
+      bigFrameChannel.commit();
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+// Reads the BigFrames of the BufferedChannel in place.
+COROUTINE(zeroCopyBigReadCoroutine) {
+  COROUTINE_LOOP() {
+    const BigFrame* frame;
+    while ((frame = bigFrameChannel.peek()) != nullptr) {
+      readCounter++;
+      readPayload = frame->sequence;
+      bigFrameChannel.release();
+    }
+    COROUTINE_YIELD();
+  }
+}
+
+#endif
+
 //-----------------------------------------------------------------------------
 
-// Determine time taken by just the counter.
-uint32_t benchmarkCountCoroutine() {
-  // Disable the channel writer and reader.
+// Suspend all the channel writers and readers, leaving only the counter.
+void suspendChannelCoroutines() {
   countCoroutine.resume();
   writeCoroutine.suspend();
   readCoroutine.suspend();
+  bufferedWriteCoroutine.suspend();
+  bufferedReadCoroutine.suspend();
+  frameWriteCoroutine.suspend();
+  frameReadCoroutine.suspend();
+  bufferedFrameWriteCoroutine.suspend();
+  bufferedFrameReadCoroutine.suspend();
+  zeroCopyWriteCoroutine.suspend();
+  zeroCopyReadCoroutine.suspend();
+#if defined(EPOXY_DUINO)
+  bufferedBigFrameWriteCoroutine.suspend();
+  bufferedBigFrameReadCoroutine.suspend();
+  zeroCopyBigWriteCoroutine.suspend();
+  zeroCopyBigReadCoroutine.suspend();
+#endif
+}
 
+// Determine the time taken to increment the counter to NUM_COUNT.
+uint32_t runCounter() {
   counter = writeCounter = readCounter = 0;
   yield();
   uint32_t startMillis = millis();
@@ -119,21 +321,18 @@ uint32_t benchmarkCountCoroutine() {
   return elapsedMillis;
 }
 
-// Determine time taken by adding the read and write coroutines
-uint32_t benchmarkReadWriteChannels() {
-  countCoroutine.resume();
-  writeCoroutine.resume();
-  readCoroutine.resume();
+// Determine time taken by just the counter.
+uint32_t benchmarkCountCoroutine() {
+  suspendChannelCoroutines();
+  return runCounter();
+}
 
-  counter = writeCounter = readCounter = 0;
-  yield();
-  uint32_t startMillis = millis();
-  while (counter < NUM_COUNT) {
-    CoroutineScheduler::loop();
-  }
-  uint32_t elapsedMillis = millis() - startMillis;
-  yield();
-  return elapsedMillis;
+// Determine time taken by adding the given writer and reader coroutines.
+uint32_t benchmarkChannel(Coroutine& writer, Coroutine& reader) {
+  suspendChannelCoroutines();
+  writer.resume();
+  reader.resume();
+  return runCounter();
 }
 
 void printStats(
@@ -172,10 +371,41 @@ void setup() {
   printStats(F("Baseline"), durationMillis, NUM_COUNT,
       writeCounter, readCounter);
 
-  durationMillis = benchmarkReadWriteChannels();
+  durationMillis = benchmarkChannel(writeCoroutine, readCoroutine);
   printStats(F("Channels"), durationMillis, NUM_COUNT,
       writeCounter, readCounter);
 
+  durationMillis = benchmarkChannel(
+      bufferedWriteCoroutine, bufferedReadCoroutine);
+  printStats(F("Buffered"), durationMillis, NUM_COUNT,
+      writeCounter, readCounter);
+
+  durationMillis = benchmarkChannel(frameWriteCoroutine, frameReadCoroutine);
+  printStats(F("Channels64"), durationMillis, NUM_COUNT,
+      writeCounter, readCounter);
+
+  durationMillis = benchmarkChannel(
+      bufferedFrameWriteCoroutine, bufferedFrameReadCoroutine);
+  printStats(F("Buffered64"), durationMillis, NUM_COUNT,
+      writeCounter, readCounter);
+
+  durationMillis = benchmarkChannel(
+      zeroCopyWriteCoroutine, zeroCopyReadCoroutine);
+  printStats(F("ZeroCopy64"), durationMillis, NUM_COUNT,
+      writeCounter, readCounter);
+
+#if defined(EPOXY_DUINO)
+  durationMillis = benchmarkChannel(
+      bufferedBigFrameWriteCoroutine, bufferedBigFrameReadCoroutine);
+  printStats(F("Buffered1K"), durationMillis, NUM_COUNT,
+      writeCounter, readCounter);
+
+  durationMillis = benchmarkChannel(
+      zeroCopyBigWriteCoroutine, zeroCopyBigReadCoroutine);
+  printStats(F("ZeroCopy1K"), durationMillis, NUM_COUNT,
+      writeCounter, readCounter);
+#endif
+
   SERIAL_PORT_MONITOR.println(F("END"));
 
 #if defined(EPOXY_DUINO)
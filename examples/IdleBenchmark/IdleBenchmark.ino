@@ -0,0 +1,149 @@
+/*
+ * This sketch measures the CPU usage of a typical application, where every
+ * coroutine spends most of its time in a COROUTINE_DELAY(), using 2 different
+ * ways of running the CoroutineScheduler:
+ *
+ *    * "loop": the original CoroutineScheduler::loop(), which spins
+ *      through the coroutines continuously, even if none of them is ready.
+ *    * "idle": CoroutineScheduler::loopUntilIdle(), with an idle hook which
+ *      sleeps until the time returned by getNextWakeupMicros().
+ *
+ * On a Linux or MacOS host using EpoxyDuino, the idle hook calls nanosleep(),
+ * and the CPU usage is measured using clock(). On a microcontroller, the idle
+ * hook simply calls delayMicroseconds() (a real application would enter a low
+ * power mode instead), and the CPU usage is the fraction of the time spent
+ * outside of the idle hook.
+ *
+ * The number of times that each coroutine ran is printed for both modes, to
+ * verify that they do the same amount of work.
+ */
+
+#include <stdint.h> // uint32_t
+#include <Arduino.h>
+#include <AceRoutine.h>
+#if defined(EPOXY_DUINO)
+  #include <time.h> // clock(), nanosleep()
+#endif
+using namespace ace_routine;
+
+#if ! defined(SERIAL_PORT_MONITOR)
+  #define SERIAL_PORT_MONITOR Serial
+#endif
+
+const uint32_t DURATION_MILLIS = 2000;
+
+/** Longest sleep of the idle hook, in case no coroutine will wake up. */
+const uint32_t MAX_SLEEP_MICROS = 100000;
+
+static uint16_t blinkCount;
+static uint16_t sensorCount;
+static uint16_t pwmCount;
+static uint32_t sleepMicros;
+
+// Toggles an LED every 500 milliseconds.
+COROUTINE(blink) {
+  COROUTINE_LOOP() {
+    blinkCount++;
+    COROUTINE_DELAY(500);
+  }
+}
+
+// Reads a sensor every 10 milliseconds.
+COROUTINE(sensor) {
+  COROUTINE_LOOP() {
+    sensorCount++;
+    COROUTINE_DELAY(10);
+  }
+}
+
+// Updates a software PWM every 2000 microseconds.
+COROUTINE(pwm) {
+  COROUTINE_LOOP() {
+    pwmCount++;
+    COROUTINE_DELAY_MICROS(2000);
+  }
+}
+
+// Sleep until the next coroutine is ready.
+void idleHook(uint32_t micros) {
+  if (micros > MAX_SLEEP_MICROS) micros = MAX_SLEEP_MICROS;
+
+  uint32_t startMicros = ::micros();
+#if defined(EPOXY_DUINO)
+  struct timespec ts;
+  ts.tv_sec = 0;
+  ts.tv_nsec = micros * 1000;
+  nanosleep(&ts, nullptr);
+#else
+  delay(micros / 1000);
+  delayMicroseconds(micros % 1000);
+#endif
+  sleepMicros += ::micros() - startMicros;
+}
+
+//-----------------------------------------------------------------------------
+
+// Run the scheduler for DURATION_MILLIS, using either loop() or
+// loopUntilIdle(), and print the results.
+void runBenchmark(const __FlashStringHelper* label, bool idle) {
+  blinkCount = 0;
+  sensorCount = 0;
+  pwmCount = 0;
+  sleepMicros = 0;
+  blink.reset();
+  sensor.reset();
+  pwm.reset();
+  CoroutineScheduler::setIdleHook(idleHook);
+  CoroutineScheduler::setup();
+
+#if defined(EPOXY_DUINO)
+  clock_t startClock = clock();
+#endif
+  uint32_t startMillis = millis();
+  while ((uint32_t) (millis() - startMillis) < DURATION_MILLIS) {
+    if (idle) {
+      CoroutineScheduler::loopUntilIdle();
+    } else {
+      CoroutineScheduler::loop();
+    }
+  }
+  uint32_t elapsedMillis = millis() - startMillis;
+
+#if defined(EPOXY_DUINO)
+  uint32_t cpuMillis = (uint32_t) (clock() - startClock)
+      / (CLOCKS_PER_SEC / 1000);
+#else
+  uint32_t cpuMillis = elapsedMillis - sleepMicros / 1000;
+#endif
+
+  SERIAL_PORT_MONITOR.print(label);
+  SERIAL_PORT_MONITOR.print(F(": cpu="));
+  SERIAL_PORT_MONITOR.print(cpuMillis * 100 / elapsedMillis);
+  SERIAL_PORT_MONITOR.print(F("% blink="));
+  SERIAL_PORT_MONITOR.print(blinkCount);
+  SERIAL_PORT_MONITOR.print(F(" sensor="));
+  SERIAL_PORT_MONITOR.print(sensorCount);
+  SERIAL_PORT_MONITOR.print(F(" pwm="));
+  SERIAL_PORT_MONITOR.println(pwmCount);
+}
+
+//-----------------------------------------------------------------------------
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  SERIAL_PORT_MONITOR.begin(115200);
+  while (!SERIAL_PORT_MONITOR); // Leonardo/Micro
+
+  SERIAL_PORT_MONITOR.println(F("BENCHMARKS"));
+  runBenchmark(F("loop"), false);
+  runBenchmark(F("idle"), true);
+  SERIAL_PORT_MONITOR.println(F("END"));
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+void loop() {}
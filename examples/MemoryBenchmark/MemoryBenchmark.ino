@@ -43,6 +43,10 @@
 #define FEATURE_SCHEDULER_LOG_BIN_JSON_RENDERER 25
 #define FEATURE_BLINK_FUNCTION 26
 #define FEATURE_BLINK_COROUTINE 27
+#define FEATURE_STATIC_SCHEDULER_ONE_COROUTINE 28
+#define FEATURE_STATIC_SCHEDULER_TWO_COROUTINES 29
+#define FEATURE_CRTP_SCHEDULER_ONE_COROUTINE 30
+#define FEATURE_CRTP_SCHEDULER_TWO_COROUTINES 31
 
 #if FEATURE != FEATURE_BASELINE
   #include <AceRoutine.h>
@@ -512,6 +516,98 @@ volatile int disableCompilerOptimization = 0;
     }
   }
 
+#elif FEATURE == FEATURE_STATIC_SCHEDULER_ONE_COROUTINE
+
+  class MyCoroutine : public Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutine a;
+
+  using StaticScheduler = StaticCoroutineScheduler<STATIC_COROUTINE(a)>;
+
+#elif FEATURE == FEATURE_STATIC_SCHEDULER_TWO_COROUTINES
+
+  class MyCoroutineA : public Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  class MyCoroutineB : public Coroutine {
+    public:
+      int runCoroutine() override {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutineA a;
+  MyCoroutineB b;
+
+  using StaticScheduler = StaticCoroutineScheduler<
+      STATIC_COROUTINE(a),
+      STATIC_COROUTINE(b)
+  >;
+
+#elif FEATURE == FEATURE_CRTP_SCHEDULER_ONE_COROUTINE
+
+  class MyCoroutine : public CrtpCoroutine<MyCoroutine> {
+    public:
+      int runCoroutine() {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutine a;
+
+  using StaticScheduler = StaticCoroutineScheduler<STATIC_COROUTINE(a)>;
+
+#elif FEATURE == FEATURE_CRTP_SCHEDULER_TWO_COROUTINES
+
+  class MyCoroutineA : public CrtpCoroutine<MyCoroutineA> {
+    public:
+      int runCoroutine() {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  class MyCoroutineB : public CrtpCoroutine<MyCoroutineB> {
+    public:
+      int runCoroutine() {
+        COROUTINE_LOOP() {
+          disableCompilerOptimization = 1;
+          COROUTINE_DELAY(10);
+        }
+      }
+  };
+
+  MyCoroutineA a;
+  MyCoroutineB b;
+
+  using StaticScheduler = StaticCoroutineScheduler<
+      STATIC_COROUTINE(a),
+      STATIC_COROUTINE(b)
+  >;
+
 #endif
 
 // TeensyDuino seems to pull in malloc() and free() when a class with virtual
@@ -645,5 +741,13 @@ void loop() {
   blink.runCoroutine();
 #elif FEATURE == FEATURE_BLINK_FUNCTION
   blink();
+#elif FEATURE == FEATURE_STATIC_SCHEDULER_ONE_COROUTINE
+  StaticScheduler::loop();
+#elif FEATURE == FEATURE_STATIC_SCHEDULER_TWO_COROUTINES
+  StaticScheduler::loop();
+#elif FEATURE == FEATURE_CRTP_SCHEDULER_ONE_COROUTINE
+  StaticScheduler::loop();
+#elif FEATURE == FEATURE_CRTP_SCHEDULER_TWO_COROUTINES
+  StaticScheduler::loop();
 #endif
 }
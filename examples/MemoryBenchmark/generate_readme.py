@@ -154,6 +154,32 @@ calculated flash size can jump around in unexpected ways.
         * ESP32 Core from 2.0.2 to 2.0.5
         * Teensyduino from 1.56 to 1.57
 
+* Unreleased
+    * Add `Static Scheduler, One Coroutine` and `Static Scheduler, Two
+      Coroutines`, which run the same coroutines as `Scheduler, One Coroutine
+      (millis)` and `Scheduler, Two Coroutines (millis)` through a
+      `StaticCoroutineScheduler` instead of the `CoroutineScheduler`.
+        * Compiled with EpoxyDuino on a Linux x86-64 host, the static scheduler
+          uses about 4.1 kB less flash (text) and 144 bytes less static RAM
+          (bss) than the `CoroutineScheduler`, because none of the code of the
+          `CoroutineScheduler` is linked in.
+    * Add `CRTP Scheduler, One Coroutine` and `CRTP Scheduler, Two
+      Coroutines`, which run the same coroutines defined as `CrtpCoroutine`
+      through a `StaticCoroutineScheduler`.
+        * Compiled with EpoxyDuino on a Linux x86-64 host, the 2 CRTP
+          coroutines use about 950 bytes less flash (text), 168 bytes less
+          initialized RAM (data, the vtables), and 168 bytes less static RAM
+          (bss) than the 2 `Coroutine` instances of `Static Scheduler, Two
+          Coroutines`. On the same host, `sizeof()` of each instance is 16
+          bytes, instead of 72 bytes for a `Coroutine`.
+        * The `*.txt` files of the microcontrollers have not been regenerated
+          yet, so these rows do not appear in the tables below. In particular,
+          the saving of the vptr and the vtables on the Nano and the Micro is
+          not measured. It is only expected from the layout: 2 bytes of
+          `sizeof()` per instance, plus the vtable in flash and RAM. To measure
+          it, run `make nano.txt micro.txt` with the boards attached, then
+          `make README.md`.
+
 ## How to Generate
 
 This requires the [AUniter](https://github.com/bxparks/AUniter) script
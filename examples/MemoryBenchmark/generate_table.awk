@@ -34,6 +34,10 @@ BEGIN {
   labels[25] = "Scheduler, LogBinJsonRenderer"
   labels[26] = "Blink Function"
   labels[27] = "Blink Coroutine"
+  labels[28] = "Static Scheduler, One Coroutine"
+  labels[29] = "Static Scheduler, Two Coroutines"
+  labels[30] = "CRTP Scheduler, One Coroutine"
+  labels[31] = "CRTP Scheduler, Two Coroutines"
   record_index = 0
 }
 {
@@ -68,6 +72,8 @@ END {
       || labels[i] ~ /^Scheduler, One Coroutine, Profiler$/ \
       || labels[i] ~ /^Scheduler, LogBinProfiler$/ \
       || labels[i] ~ /^Blink Function$/ \
+      || labels[i] ~ /^Static Scheduler, One Coroutine$/ \
+      || labels[i] ~ /^CRTP Scheduler, One Coroutine$/ \
     ) {
       printf("|---------------------------------------+--------------+-------------|\n")
     }
@@ -8,7 +8,7 @@
 #include <AceRoutine.h>
 
 #define CHANNEL_TYPE_SYNC 0
-#define CHANNEL_TYPE_NO_SYNC 1
+#define CHANNEL_TYPE_BUFFERED 1
 #define CHANNEL_TYPE CHANNEL_TYPE_SYNC
 
 #define TEST_TYPE_LOOP 0
@@ -17,72 +17,6 @@
 
 using namespace ace_routine;
 
-/**
- * An unbuffered channel that provides no synchronization. Perhaps better
- * described as a buffered channel of size 1.
- *
- * Because of the buffering of size one, sending 10 integers from the writer to
- * the reader has the following order:
- *
- * @code
- * Writer: sending 0
- * Writer: sending 1
- * Reader: received 0
- * Writer: sending 2
- * Reader: received 1
- * Writer: sending 3
- * Reader: received 2
- * ...
- * @endcode
- *
- * In other words, the receiver is one iteration behind the writer.
- *
- * TODO: Figure out if it's useful to move into the src/ace_time/ directory,
- * perhaps as a BufferedChannel?
- */
-template<typename T>
-class NoSyncChannel {
-  public:
-    void setValue(const T& value) {
-      mValueToWrite = value;
-    }
-
-    bool write() {
-      if (mDataReady) {
-        return false;
-      } else {
-        mValue = mValueToWrite;
-        mDataReady = true;
-        return true;
-      }
-    }
-
-    bool write(const T& value) {
-      if (mDataReady) {
-        return false;
-      } else {
-        mValue = value;
-        mDataReady = true;
-        return true;
-      }
-    }
-
-    bool read(T& value) {
-      if (mDataReady) {
-        value = mValue;
-        mDataReady = false;
-        return true;
-      } else {
-        return false;
-      }
-    }
-
-  private:
-    T mValue;
-    T mValueToWrite;
-    bool mDataReady = false;
-};
-
 struct Message {
   static uint8_t const kStatusOk = 0;
   static uint8_t const kStatusError = 1;
@@ -91,8 +25,19 @@ struct Message {
   int value;
 };
 
-#if CHANNEL_TYPE == CHANNEL_TYPE_NO_SYNC
-  NoSyncChannel<Message> channel;
+#if CHANNEL_TYPE == CHANNEL_TYPE_BUFFERED
+  // A BufferedChannel of size 1 provides no synchronization. Sending 10
+  // integers from the writer to the reader has the following order:
+  //
+  //  Writer: sending 0
+  //  Writer: sending 1
+  //  Reader: received 0
+  //  Writer: sending 2
+  //  Reader: received 1
+  //  ...
+  //
+  // In other words, the receiver is one iteration behind the writer.
+  BufferedChannel<Message, 1> channel;
 #elif CHANNEL_TYPE == CHANNEL_TYPE_SYNC
   // This is a synchronized unbuffered Channel.
   Channel<Message> channel;
@@ -0,0 +1,183 @@
+/*
+ * This sketch measures the wake-up latency of a 'control' coroutine, which
+ * stands in for a motor-control or communications task, while N
+ * 'housekeeping' coroutines compete for the CPU. The control coroutine sleeps
+ * for about 1 millisecond using COROUTINE_DELAY_MICROS(), and records how late
+ * it actually runs after its delay has expired. The sleep period is varied
+ * slightly on each iteration so that it does not synchronize with the
+ * round-robin cycle of the housekeeping coroutines. Each housekeeping coroutine
+ * burns a fixed amount of CPU time, then yields. The latency is measured
+ * twice:
+ *
+ *    * "same": the control coroutine has the same (lowest) priority as the
+ *      housekeeping coroutines, so it must wait for its turn in the
+ *      round-robin order.
+ *    * "high": the control coroutine has the highest priority, so it runs as
+ *      soon as the currently running housekeeping coroutine yields.
+ *
+ * For each run, the average, the 99th percentile, and the maximum latency are
+ * printed in microseconds. On a microcontroller, the maximum is the true worst
+ * case. On a Linux or MacOS host, the maximum also includes the times when the
+ * process was preempted by the operating system, so the 99th percentile is a
+ * better indicator of the worst case caused by the scheduler.
+ *
+ * The housekeeping coroutines are created on the heap so that the number of
+ * them can be increased between the runs. This is intended to be run on a
+ * Linux or MacOS host using EpoxyDuino, but it also runs on microcontrollers.
+ */
+
+#include <stdint.h> // uint32_t
+#include <string.h> // memset()
+#include <Arduino.h>
+#include <AceRoutine.h>
+using namespace ace_routine;
+
+#if ! defined(SERIAL_PORT_MONITOR)
+  #define SERIAL_PORT_MONITOR Serial
+#endif
+
+#if defined(EPOXY_DUINO)
+  const uint32_t DURATION_MILLIS = 1000;
+  const uint16_t HOUSEKEEPER_COUNTS[] = {0, 10, 50, 100};
+#elif defined(ARDUINO_ARCH_AVR)
+  const uint32_t DURATION_MILLIS = 2000;
+  const uint16_t HOUSEKEEPER_COUNTS[] = {0, 5, 10, 20};
+#else
+  const uint32_t DURATION_MILLIS = 2000;
+  const uint16_t HOUSEKEEPER_COUNTS[] = {0, 10, 20, 50};
+#endif
+
+const uint8_t NUM_RUNS =
+    sizeof(HOUSEKEEPER_COUNTS) / sizeof(HOUSEKEEPER_COUNTS[0]);
+
+/** CPU time consumed by each housekeeping coroutine before it yields. */
+const uint16_t WORK_MICROS = 20;
+
+/** Minimum sleep period of the control coroutine. */
+const uint16_t PERIOD_MICROS = 500;
+
+/** Range of the variation added to PERIOD_MICROS. */
+const uint16_t JITTER_MICROS = 1000;
+
+/** Width of each bucket of the latency histogram. */
+const uint16_t BUCKET_MICROS = 64;
+
+/** Number of buckets. The last one also holds all larger latencies. */
+const uint8_t NUM_BUCKETS = 32;
+
+static uint32_t maxLatency;
+static uint32_t sumLatency;
+static uint32_t numWakeups;
+static uint16_t histogram[NUM_BUCKETS];
+
+// Coroutine which measures how late it wakes up after each delay.
+class ControlCoroutine : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        mPeriod = PERIOD_MICROS + (uint16_t) (numWakeups * 397) % JITTER_MICROS;
+        mSleepStart = micros();
+        COROUTINE_DELAY_MICROS(mPeriod);
+        uint32_t latency = micros() - mSleepStart - mPeriod;
+        if (latency > maxLatency) maxLatency = latency;
+        sumLatency += latency;
+        numWakeups++;
+        uint32_t bucket = latency / BUCKET_MICROS;
+        histogram[bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1]++;
+      }
+    }
+
+  private:
+    uint32_t mSleepStart;
+    uint16_t mPeriod;
+};
+
+// Coroutine which burns WORK_MICROS of CPU time on each iteration.
+class Housekeeper : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        uint32_t start = micros();
+        while ((uint32_t) (micros() - start) < WORK_MICROS) {}
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+ControlCoroutine control;
+
+//-----------------------------------------------------------------------------
+
+// Run the scheduler for DURATION_MILLIS, with the control coroutine at the
+// given priority.
+void runBenchmark(uint8_t priority) {
+  control.setPriority(priority);
+  CoroutineScheduler::setup();
+
+  maxLatency = 0;
+  sumLatency = 0;
+  numWakeups = 0;
+  memset(histogram, 0, sizeof(histogram));
+  yield();
+  uint32_t startMillis = millis();
+  while ((uint32_t) (millis() - startMillis) < DURATION_MILLIS) {
+    CoroutineScheduler::loop();
+  }
+  yield();
+}
+
+// Return the upper bound of the histogram bucket which contains the 99th
+// percentile of the latencies.
+uint32_t percentile99() {
+  uint32_t threshold = numWakeups - numWakeups / 100;
+  uint32_t count = 0;
+  uint8_t i = 0;
+  for (; i < NUM_BUCKETS - 1; i++) {
+    count += histogram[i];
+    if (count >= threshold) break;
+  }
+  return (uint32_t) (i + 1) * BUCKET_MICROS;
+}
+
+void printLatency() {
+  SERIAL_PORT_MONITOR.print(' ');
+  SERIAL_PORT_MONITOR.print(numWakeups ? sumLatency / numWakeups : 0);
+  SERIAL_PORT_MONITOR.print(' ');
+  SERIAL_PORT_MONITOR.print(percentile99());
+  SERIAL_PORT_MONITOR.print(' ');
+  SERIAL_PORT_MONITOR.print(maxLatency);
+}
+
+//-----------------------------------------------------------------------------
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  SERIAL_PORT_MONITOR.begin(115200);
+  while (!SERIAL_PORT_MONITOR); // Leonardo/Micro
+
+  SERIAL_PORT_MONITOR.println(F("BENCHMARKS"));
+
+  uint16_t numHousekeepers = 0;
+  for (uint8_t i = 0; i < NUM_RUNS; i++) {
+    for (; numHousekeepers < HOUSEKEEPER_COUNTS[i]; numHousekeepers++) {
+      new Housekeeper();
+    }
+
+    SERIAL_PORT_MONITOR.print(numHousekeepers);
+    runBenchmark(Coroutine::kPriorityLowest);
+    printLatency();
+    runBenchmark(Coroutine::kPriorityHighest);
+    printLatency();
+    SERIAL_PORT_MONITOR.println();
+  }
+
+  SERIAL_PORT_MONITOR.println(F("END"));
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+void loop() {}
@@ -0,0 +1,147 @@
+/*
+ * This sketch measures the throughput of the ThreadedCoroutineScheduler as a
+ * function of the number of worker threads. NUM_COROUTINES coroutines are
+ * created, each of which performs NUM_STEPS steps of CPU-bound work
+ * (WORK_ITERATIONS iterations of a pseudo-random number generator), yielding
+ * after each step, then terminates. The elapsed time to run all coroutines to
+ * completion is measured, and printed with the number of steps per second.
+ *
+ * The single-threaded CoroutineScheduler is measured first as the baseline.
+ *
+ * This runs only on a Linux or MacOS host using EpoxyDuino, because the
+ * ThreadedCoroutineScheduler requires the C++ thread library.
+ */
+
+#include <stdint.h> // uint32_t
+#include <Arduino.h>
+#include <AceRoutine.h>
+using namespace ace_routine;
+
+#if ! defined(SERIAL_PORT_MONITOR)
+  #define SERIAL_PORT_MONITOR Serial
+#endif
+
+#if defined(EPOXY_DUINO)
+
+#include <thread> // std::thread::hardware_concurrency()
+#include <ace_routine/ThreadedCoroutineScheduler.h>
+
+const uint16_t NUM_COROUTINES = 2000;
+const uint16_t NUM_STEPS = 50;
+const uint16_t WORK_ITERATIONS = 1000;
+const uint8_t THREAD_COUNTS[] = {1, 2, 4, 8};
+const uint8_t NUM_RUNS = sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]);
+
+// Coroutine which performs NUM_STEPS steps of CPU-bound work.
+class Worker : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      for (mStep = 0; mStep < NUM_STEPS; mStep++) {
+        for (uint16_t i = 0; i < WORK_ITERATIONS; i++) {
+          mState = mState * 1664525 + 1013904223;
+        }
+        COROUTINE_YIELD();
+      }
+      COROUTINE_END();
+    }
+
+    /** Prevents the compiler from optimizing away the work. */
+    uint32_t getState() const { return mState; }
+
+  private:
+    uint16_t mStep;
+    uint32_t mState = 1;
+};
+
+// Check the results, to prevent the work from being optimized away.
+void checkWorkers(Worker* workers) {
+  uint32_t expected = workers[0].getState();
+  for (uint16_t i = 0; i < NUM_COROUTINES; i++) {
+    if (workers[i].getState() != expected || ! workers[i].isTerminated()) {
+      SERIAL_PORT_MONITOR.println(F("check failed"));
+      return;
+    }
+  }
+}
+
+void printResult(const __FlashStringHelper* label, uint32_t threads,
+    uint32_t elapsedMillis) {
+  uint32_t stepsPerSecond = (uint32_t) ((uint64_t) NUM_COROUTINES * NUM_STEPS
+      * 1000 / (elapsedMillis ? elapsedMillis : 1));
+  SERIAL_PORT_MONITOR.print(label);
+  SERIAL_PORT_MONITOR.print(' ');
+  SERIAL_PORT_MONITOR.print(threads);
+  SERIAL_PORT_MONITOR.print(' ');
+  SERIAL_PORT_MONITOR.print(elapsedMillis);
+  SERIAL_PORT_MONITOR.print(' ');
+  SERIAL_PORT_MONITOR.println(stepsPerSecond);
+}
+
+// Run the workers using the default single-threaded CoroutineScheduler.
+void runSingleThreaded() {
+  Worker* workers = new Worker[NUM_COROUTINES];
+  CoroutineScheduler::setup();
+
+  uint32_t startMillis = millis();
+  for (uint32_t i = 0; i < (uint32_t) NUM_COROUTINES * (NUM_STEPS + 2); i++) {
+    CoroutineScheduler::loop();
+  }
+  uint32_t elapsedMillis = millis() - startMillis;
+
+  checkWorkers(workers);
+  printResult(F("CoroutineScheduler"), 1, elapsedMillis);
+
+  // Move the workers out of the global list before deleting them.
+  CoroutineScheduler detached;
+  for (uint16_t i = 0; i < NUM_COROUTINES; i++) {
+    detached.addCoroutine(workers[i]);
+  }
+  delete[] workers;
+}
+
+// Run the workers using the ThreadedCoroutineScheduler.
+void runThreaded(uint8_t numThreads) {
+  Worker* workers = new Worker[NUM_COROUTINES];
+  ThreadedCoroutineScheduler scheduler(numThreads);
+  for (uint16_t i = 0; i < NUM_COROUTINES; i++) {
+    scheduler.addCoroutine(workers[i]);
+  }
+
+  uint32_t startMillis = millis();
+  scheduler.start();
+  scheduler.waitUntilTerminated();
+  uint32_t elapsedMillis = millis() - startMillis;
+
+  checkWorkers(workers);
+  printResult(F("ThreadedCoroutineScheduler"), numThreads, elapsedMillis);
+  delete[] workers;
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  SERIAL_PORT_MONITOR.begin(115200);
+  while (!SERIAL_PORT_MONITOR); // Leonardo/Micro
+
+#if defined(EPOXY_DUINO)
+  SERIAL_PORT_MONITOR.print(F("hardware_concurrency "));
+  SERIAL_PORT_MONITOR.println(std::thread::hardware_concurrency());
+  SERIAL_PORT_MONITOR.println(F("BENCHMARKS"));
+  runSingleThreaded();
+  for (uint8_t i = 0; i < NUM_RUNS; i++) {
+    runThreaded(THREAD_COUNTS[i]);
+  }
+  SERIAL_PORT_MONITOR.println(F("END"));
+  exit(0);
+#else
+  SERIAL_PORT_MONITOR.println(F("Supported only on Linux or MacOS"));
+#endif
+}
+
+void loop() {}
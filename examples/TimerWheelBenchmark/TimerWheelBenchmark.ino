@@ -0,0 +1,125 @@
+/*
+ * This sketch measures the cost of one pass of the CoroutineScheduler through
+ * the ready coroutines, as the number of sleeping coroutines grows. A single
+ * 'counter' coroutine yields on every iteration, and N 'sleeper' coroutines
+ * are blocked in a long COROUTINE_DELAY(). The time per iteration of the
+ * counter is measured twice:
+ *
+ *    * "polling": the original behavior, where the scheduler calls
+ *      runCoroutine() on each sleeper to check whether its delay has expired.
+ *    * "wheel": a TimerWheel is attached to the scheduler, so the sleepers are
+ *      parked in the wheel and are not touched until their delay expires.
+ *
+ * The sleepers are created on the heap so that the number of them can be
+ * increased between the runs. This is intended to be run on a Linux or MacOS
+ * host using EpoxyDuino, but it also runs on microcontrollers with a reduced
+ * number of sleepers.
+ */
+
+#include <stdint.h> // uint32_t
+#include <Arduino.h>
+#include <AceRoutine.h>
+#include <AceCommon.h> // printUint32AsFloat3To()
+using namespace ace_routine;
+using ace_common::printUint32AsFloat3To;
+
+#if ! defined(SERIAL_PORT_MONITOR)
+  #define SERIAL_PORT_MONITOR Serial
+#endif
+
+#if defined(EPOXY_DUINO)
+  const uint32_t NUM_COUNT = 200000;
+  const uint16_t SLEEPER_COUNTS[] = {0, 10, 100, 1000, 5000};
+#elif defined(ARDUINO_ARCH_AVR)
+  const uint32_t NUM_COUNT = 10000;
+  const uint16_t SLEEPER_COUNTS[] = {0, 5, 10, 20};
+#else
+  const uint32_t NUM_COUNT = 50000;
+  const uint16_t SLEEPER_COUNTS[] = {0, 10, 50, 100};
+#endif
+
+const uint8_t NUM_RUNS = sizeof(SLEEPER_COUNTS) / sizeof(SLEEPER_COUNTS[0]);
+
+static volatile uint32_t counter = 0;
+
+// Coroutine that simply increments the counter.
+COROUTINE(countCoroutine) {
+  COROUTINE_LOOP() {
+    counter++;
+    COROUTINE_YIELD();
+  }
+}
+
+// A coroutine that sleeps for much longer than the duration of the benchmark.
+class Sleeper : public Coroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(30000);
+      }
+    }
+};
+
+TimerWheel<64> timerWheel;
+
+//-----------------------------------------------------------------------------
+
+// Return the number of milliseconds to increment the counter to NUM_COUNT.
+uint32_t runBenchmark(TimerWheelBase* wheel) {
+  CoroutineScheduler::setTimerWheel(wheel);
+  CoroutineScheduler::setup();
+
+  // Let every sleeper run once, so that it enters its COROUTINE_DELAY().
+  counter = 0;
+  while (counter < 2) {
+    CoroutineScheduler::loop();
+  }
+
+  counter = 0;
+  yield();
+  uint32_t startMillis = millis();
+  while (counter < NUM_COUNT) {
+    CoroutineScheduler::loop();
+  }
+  uint32_t elapsedMillis = millis() - startMillis;
+  yield();
+  return elapsedMillis;
+}
+
+void printMicrosPerCount(uint32_t durationMillis) {
+  uint32_t nanos = durationMillis * 1000 / (NUM_COUNT / 1000);
+  SERIAL_PORT_MONITOR.print(' ');
+  printUint32AsFloat3To(SERIAL_PORT_MONITOR, nanos);
+}
+
+//-----------------------------------------------------------------------------
+
+void setup() {
+#if ! defined(EPOXY_DUINO)
+  delay(1000);
+#endif
+  SERIAL_PORT_MONITOR.begin(115200);
+  while (!SERIAL_PORT_MONITOR); // Leonardo/Micro
+
+  SERIAL_PORT_MONITOR.println(F("BENCHMARKS"));
+
+  uint16_t numSleepers = 0;
+  for (uint8_t i = 0; i < NUM_RUNS; i++) {
+    for (; numSleepers < SLEEPER_COUNTS[i]; numSleepers++) {
+      new Sleeper();
+    }
+
+    SERIAL_PORT_MONITOR.print(numSleepers);
+    printMicrosPerCount(runBenchmark(nullptr));
+    printMicrosPerCount(runBenchmark(&timerWheel));
+    SERIAL_PORT_MONITOR.println();
+  }
+
+  SERIAL_PORT_MONITOR.println(F("END"));
+
+#if defined(EPOXY_DUINO)
+  exit(0);
+#endif
+}
+
+void loop() {}
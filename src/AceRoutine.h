@@ -47,11 +47,26 @@ SOFTWARE.
 #define ACE_ROUTINE_VERSION_STRING "1.5.1"
 
 #include "ace_routine/Coroutine.h"
+#include "ace_routine/CoroutineQueue.h"
+#include "ace_routine/TimerWheel.h"
 #include "ace_routine/CoroutineScheduler.h"
+#include "ace_routine/StaticCoroutineScheduler.h"
+#include "ace_routine/CrtpCoroutine.h"
+#include "ace_routine/CoroutinePool.h"
+#include "ace_routine/SubCoroutine.h"
+#include "ace_routine/Generator.h"
 #include "ace_routine/Channel.h"
+#include "ace_routine/BufferedChannel.h"
+#include "ace_routine/MpmcChannel.h"
+#include "ace_routine/ChannelSelector.h"
+#include "ace_routine/Event.h"
+#include "ace_routine/IsrQueue.h"
+#include "ace_routine/StallWatchdog.h"
 #include "ace_routine/CoroutineProfiler.h"
 #include "ace_routine/LogBinProfiler.h"
 #include "ace_routine/LogBinTableRenderer.h"
 #include "ace_routine/LogBinJsonRenderer.h"
+#include "ace_routine/DeadlineTableRenderer.h"
+#include "ace_routine/SchedulerStatsRenderer.h"
 
 #endif
@@ -0,0 +1,227 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_BUFFERED_CHANNEL_H
+#define ACE_ROUTINE_BUFFERED_CHANNEL_H
+
+#include <stdint.h> // uint8_t
+
+/**
+ * Wait until a slot of the BufferedChannel is free, then set the pointer
+ * `slot` to it. The value should be written in place through `slot`, then
+ * published using `channel.commit()`.
+ */
+#define COROUTINE_CHANNEL_RESERVE(channel, slot) \
+  COROUTINE_AWAIT(((slot) = (channel).reserve()) != nullptr)
+
+/**
+ * Wait until the BufferedChannel contains a value, then set the pointer `slot`
+ * to it. The value should be read in place through `slot`, then removed using
+ * `channel.release()`.
+ */
+#define COROUTINE_CHANNEL_PEEK(channel, slot) \
+  COROUTINE_AWAIT(((slot) = (channel).peek()) != nullptr)
+
+namespace ace_routine {
+
+/**
+ * A buffered channel which holds up to `T_SIZE` values in a ring buffer.
+ * Unlike the unbuffered Channel, a writer continues without waiting for the
+ * reader as long as the buffer is not full, and a reader continues without
+ * waiting for the writer as long as the buffer is not empty. A producer can
+ * write a burst of values, and the consumer can read all of them, in a single
+ * call to runCoroutine() each, instead of one context switch per value.
+ *
+ * The channel can be used with the COROUTINE_CHANNEL_WRITE() and
+ * COROUTINE_CHANNEL_READ() macros, just like Channel. The macro version of the
+ * write copies the value twice (into a temporary, then into the buffer), so
+ * the write(const T&) method should be used to write a burst of values, for
+ * example:
+ *
+ * @code
+ * COROUTINE(producer) {
+ *   COROUTINE_LOOP() {
+ *     while (! channel.isFull() && hasData()) {
+ *       channel.write(readData());
+ *     }
+ *     COROUTINE_YIELD();
+ *   }
+ * }
+ * @endcode
+ *
+ * For a large T, the values can also be transferred without copying them at
+ * all. The writer calls reserve() to get a pointer to a free slot, fills it in
+ * place, then calls commit(). The reader calls peek() to get a pointer to the
+ * oldest value, uses it in place, then calls release():
+ *
+ * @code
+ * COROUTINE(producer) {
+ *   COROUTINE_LOOP() {
+ *     Frame* frame;
+ *     COROUTINE_CHANNEL_RESERVE(channel, frame);
+ *     fillFrame(*frame);
+ *     channel.commit();
+ *   }
+ * }
+ *
+ * COROUTINE(consumer) {
+ *   COROUTINE_LOOP() {
+ *     const Frame* frame;
+ *     COROUTINE_CHANNEL_PEEK(channel, frame);
+ *     processFrame(*frame);
+ *     channel.release();
+ *   }
+ * }
+ * @endcode
+ *
+ * A BufferedChannel with `T_SIZE` of 1 behaves like a channel with no
+ * synchronization: the reader is one value behind the writer.
+ *
+ * The channel is not safe to use from an interrupt service routine.
+ *
+ * @tparam T type of the values
+ * @tparam T_SIZE number of values in the buffer, must be a power of 2, at
+ *    most 128
+ */
+template <typename T, uint8_t T_SIZE>
+class BufferedChannel {
+  static_assert(T_SIZE > 0 && T_SIZE <= 128 && (T_SIZE & (T_SIZE - 1)) == 0,
+      "T_SIZE must be a power of 2, at most 128");
+
+  public:
+    /** Constructor. */
+    BufferedChannel() {}
+
+    /** Return the maximum number of values in the buffer. */
+    static uint8_t capacity() { return T_SIZE; }
+
+    /** Return the number of values in the buffer. */
+    uint8_t size() const { return (uint8_t) (mTail - mHead); }
+
+    /** Return true if the buffer contains no values. */
+    bool isEmpty() const { return mTail == mHead; }
+
+    /** Return true if the buffer is full. */
+    bool isFull() const { return size() == T_SIZE; }
+
+    /**
+     * Used by COROUTINE_CHANNEL_WRITE() to preserve the value of the write
+     * across multiple COROUTINE_YIELD() calls. Not designed to be used
+     * directly by the user.
+     */
+    void setValue(const T& value) {
+      mValueToWrite = value;
+    }
+
+    /**
+     * Same as write(const T& value) except use the value of setValue(). Used
+     * by COROUTINE_CHANNEL_WRITE() macro. Not designed to be used directly by
+     * the user.
+     */
+    bool write() {
+      return write(mValueToWrite);
+    }
+
+    /**
+     * Append the value to the buffer and return true, or return false if the
+     * buffer is full.
+     */
+    bool write(const T& value) {
+      if (isFull()) return false;
+      mBuffer[mTail & kMask] = value;
+      mTail++;
+      return true;
+    }
+
+    /**
+     * Remove the oldest value from the buffer into `value` and return true,
+     * or return false if the buffer is empty. Can be used through the
+     * COROUTINE_CHANNEL_READ() macro.
+     */
+    bool read(T& value) {
+      if (isEmpty()) return false;
+      value = mBuffer[mHead & kMask];
+      mHead++;
+      return true;
+    }
+
+    /**
+     * Return a pointer to the next free slot of the buffer, or nullptr if the
+     * buffer is full. The value is not visible to the reader until commit()
+     * is called. Calling reserve() again before commit() returns the same
+     * slot.
+     */
+    T* reserve() {
+      return isFull() ? nullptr : &mBuffer[mTail & kMask];
+    }
+
+    /**
+     * Publish the slot returned by reserve() to the reader. Must be called
+     * only after reserve() returned a non-null pointer.
+     */
+    void commit() {
+      mTail++;
+    }
+
+    /**
+     * Return a pointer to the oldest value in the buffer, or nullptr if the
+     * buffer is empty. The value remains in the buffer until release() is
+     * called.
+     */
+    const T* peek() const {
+      return isEmpty() ? nullptr : &mBuffer[mHead & kMask];
+    }
+
+    /**
+     * Remove the value returned by peek() from the buffer, which allows the
+     * writer to reuse its slot. Must be called only after peek() returned a
+     * non-null pointer.
+     */
+    void release() {
+      mHead++;
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    BufferedChannel(const BufferedChannel&) = delete;
+    BufferedChannel& operator=(const BufferedChannel&) = delete;
+
+    static const uint8_t kMask = T_SIZE - 1;
+
+    /**
+     * Free-running read and write counters. Their difference is the number of
+     * values in the buffer, which is correct across the rollover of uint8_t
+     * because T_SIZE is a power of 2 no larger than 128.
+     */
+    uint8_t mHead = 0;
+    uint8_t mTail = 0;
+
+    T mBuffer[T_SIZE];
+    T mValueToWrite;
+};
+
+}
+
+#endif
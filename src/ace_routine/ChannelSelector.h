@@ -0,0 +1,162 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_CHANNEL_SELECTOR_H
+#define ACE_ROUTINE_CHANNEL_SELECTOR_H
+
+#include <stdint.h> // uint8_t, int8_t
+#include "Coroutine.h"
+
+/**
+ * Wait until one of the channels of the ChannelSelector has a value, read it
+ * into the variable given to ChannelSelector::add(), and set `index` to the
+ * index of that channel. Like a Go Lang select statement over several channel
+ * reads. The channels are polled before the first yield, so if one of them
+ * already has a value, the coroutine continues immediately.
+ */
+#define COROUTINE_SELECT(selector, index) \
+    do { \
+      this->setYielding(); \
+      while (((index) = (selector).select()) < 0) { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Same as COROUTINE_SELECT(), but give up after timeoutMillis milliseconds,
+ * in which case `index` is set to -1. The `index` must be an lvalue (e.g. a
+ * member variable or a static variable). The timeout uses the same storage as
+ * COROUTINE_DELAY(), like COROUTINE_AWAIT_TIMEOUT(), so it restarts the period
+ * of a COROUTINE_EVERY() in the same coroutine.
+ */
+#define COROUTINE_SELECT_TIMEOUT(selector, timeoutMillis, index) \
+    do { \
+      this->setDelayMillis(timeoutMillis); \
+      this->setYielding(); \
+      while (((index) = (selector).select()) < 0 \
+          && !this->isDelayExpired()) { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+namespace ace_routine {
+
+/**
+ * A set of up to `T_SIZE` channels which are read by a single coroutine
+ * using COROUTINE_SELECT() or COROUTINE_SELECT_TIMEOUT(). Each channel is
+ * registered with add(), along with the variable which receives its values.
+ * The channels can be of different types, as long as each of them has a
+ * non-blocking `bool read(T&)` method, i.e. Channel, BufferedChannel, or
+ * MpmcChannel.
+ *
+ * A coroutine which polls each channel in turn with a fixed order favors the
+ * first channel, which can starve the others if it is always ready. Instead,
+ * select() starts each poll at the channel after the one which was selected
+ * by the previous poll, so the channels which are ready are served in
+ * round-robin order.
+ *
+ * Each channel consumes 3 pointers of static RAM (6 bytes on AVR, 12 bytes on
+ * 32-bit processors).
+ *
+ * @tparam T_SIZE maximum number of channels, at most 127
+ */
+template <uint8_t T_SIZE>
+class ChannelSelector {
+  static_assert(T_SIZE > 0 && T_SIZE <= 127, "T_SIZE must be 1 to 127");
+
+  public:
+    /** Constructor. */
+    ChannelSelector() {}
+
+    /** Return the number of channels which were added. */
+    uint8_t size() const { return mNumChannels; }
+
+    /**
+     * Add the channel to the selector. When the channel is selected, its
+     * value is read into `value`, which must be an lvalue that survives a
+     * yield (e.g. a member variable or a static variable). Return the index of
+     * the channel, which is returned by select() when the channel is
+     * selected, or -1 if the selector is already full.
+     */
+    template <typename T_CHANNEL, typename T>
+    int8_t add(T_CHANNEL& channel, T& value) {
+      if (mNumChannels >= T_SIZE) return -1;
+      Entry& entry = mEntries[mNumChannels];
+      entry.read = &readChannel<T_CHANNEL, T>;
+      entry.channel = &channel;
+      entry.value = &value;
+      return mNumChannels++;
+    }
+
+    /**
+     * Try to read each channel once, starting with the channel after the one
+     * selected by the previous call. Return the index of the first channel
+     * which returned a value, or -1 if none of them did. Used by
+     * COROUTINE_SELECT().
+     */
+    int8_t select() {
+      uint8_t index = mNext;
+      for (uint8_t i = 0; i < mNumChannels; i++) {
+        if (index >= mNumChannels) index = 0;
+        const Entry& entry = mEntries[index];
+        if (entry.read(entry.channel, entry.value)) {
+          mNext = index + 1;
+          return index;
+        }
+        index++;
+      }
+      return -1;
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    ChannelSelector(const ChannelSelector&) = delete;
+    ChannelSelector& operator=(const ChannelSelector&) = delete;
+
+    /** A channel, without its type. */
+    struct Entry {
+      bool (*read)(void* channel, void* value);
+      void* channel;
+      void* value;
+    };
+
+    /** Restore the types of the channel and value, and call read(). */
+    template <typename T_CHANNEL, typename T>
+    static bool readChannel(void* channel, void* value) {
+      return static_cast<T_CHANNEL*>(channel)->read(*static_cast<T*>(value));
+    }
+
+    Entry mEntries[T_SIZE];
+    uint8_t mNumChannels = 0;
+
+    /** Index of the channel which is polled first by the next select(). */
+    uint8_t mNext = 0;
+};
+
+}
+
+#endif
@@ -29,9 +29,46 @@ SOFTWARE.
 #include <Print.h> // Print
 #include <AceCommon.h> // PrintStr<>
 #include "CoroutineProfiler.h"
+#include "CoroutineDeadline.h" // ACE_ROUTINE_DEADLINES
+#include "SchedulerStats.h" // ACE_ROUTINE_SCHEDULER_STATS
+#include "CoroutineQueue.h"
 #include "ClockInterface.h"
 #include "compat.h" // PROGMEM
 
+/**
+ * Set to 1 to count the periods skipped by COROUTINE_EVERY(), available from
+ * Coroutine::getOverrunCount(). Disabled by default, so that the counter is
+ * removed from each Coroutine. It must be defined to the same value in every
+ * file which includes AceRoutine.h, e.g. using a compiler flag, or a `#define`
+ * before the `#include`.
+ */
+#ifndef ACE_ROUTINE_OVERRUN_COUNT
+  #define ACE_ROUTINE_OVERRUN_COUNT 0
+#endif
+
+/**
+ * Set to 1 to let the CoroutineScheduler resume the innermost child of a
+ * COROUTINE_CALL() directly, and to delay the caller using the delay of the
+ * child (e.g. in the TimerWheel), at the cost of a pointer in each Coroutine.
+ * Disabled by default, so that the caller is resumed on each iteration, which
+ * resumes the child, and the delay of the child is polled. It must be defined
+ * to the same value in every file which includes AceRoutine.h.
+ */
+#ifndef ACE_ROUTINE_DIRECT_CALLS
+  #define ACE_ROUTINE_DIRECT_CALLS 0
+#endif
+
+/**
+ * Set to 1 to park a coroutine waiting in COROUTINE_JOIN() off the ready queue
+ * of its CoroutineScheduler until the other coroutine ends, at the cost of a
+ * pointer in each Coroutine and a queue in each CoroutineScheduler. Disabled
+ * by default, so that the other coroutine is polled on each iteration. It
+ * must be defined to the same value in every file which includes AceRoutine.h.
+ */
+#ifndef ACE_ROUTINE_JOIN_PARKING
+  #define ACE_ROUTINE_JOIN_PARKING 0
+#endif
+
 class __FlashStringHelper;
 class AceRoutineTest_statusStrings;
 class SuspendTest_suspendAndResume;
@@ -192,13 +229,88 @@ extern className##_##name name
     } while (false)
 
 /**
- * Yield for delayMillis. A delayMillis of 0 is functionally equivalent to
- * COROUTINE_YIELD(). To save memory, the delayMillis is stored as a uint16_t
- * but the actual maximum is limited to 32767 millliseconds. See
- * setDelayMillis() for the reason for this limitation.
+ * Yield until condition is true, or until timeoutMillis milliseconds have
+ * elapsed, whichever comes first. The `result` must be an lvalue (e.g. a
+ * member variable or a static variable, because local variables do not
+ * survive a yield) which is set to `true` if the condition became true, or to
+ * `false` if the timeout expired. If both happen on the same poll, the
+ * condition wins.
+ *
+ * The timeout uses the same storage as COROUTINE_DELAY(), so a coroutine does
+ * not need any additional RAM, and the clock is read only when the condition
+ * is false. For the same reason, it restarts the period of a COROUTINE_EVERY()
+ * in the same coroutine. The coroutine is in the Yielding state while it
+ * waits, so the CoroutineScheduler keeps it on the ready queue to poll the
+ * condition, instead of placing it into the TimerWheel.
+ */
+#define COROUTINE_AWAIT_TIMEOUT(condition, timeoutMillis, result) \
+    do { \
+      this->setDelayMillis(timeoutMillis); \
+      this->setYielding(); \
+      do { \
+        COROUTINE_YIELD_INTERNAL(); \
+        (result) = (condition); \
+      } while (!(result) && !this->isDelayExpired()); \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Wait until the other coroutine is done, i.e. it has executed
+ * COROUTINE_END(), then continue. If it is already done, the coroutine
+ * continues immediately. To wait for several coroutines (fan-in), use one
+ * COROUTINE_JOIN() for each of them. The order does not matter, because a
+ * join on a coroutine which is already done does not yield.
+ *
+ * If ACE_ROUTINE_JOIN_PARKING is set to 1, and both coroutines are run by the
+ * same CoroutineScheduler, the waiting coroutine is removed from the ready
+ * queue while it waits, so unlike
+ * COROUTINE_AWAIT(other.isDone()), it consumes no CPU time until the other
+ * coroutine executes COROUTINE_END(). Otherwise (e.g. when either one is
+ * called directly, they belong to different schedulers, or they are run by
+ * the ThreadedCoroutineScheduler), the other coroutine is polled on each
+ * call.
+ */
+#define COROUTINE_JOIN(coroutine) \
+    do { \
+      this->setYielding(); \
+      while (!this->join(coroutine)) { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Call the child coroutine, usually a SubCoroutine, from the beginning, and
+ * continue when it executes COROUTINE_END(). The child can use
+ * COROUTINE_YIELD(), COROUTINE_DELAY() and the other macros, including a
+ * nested COROUTINE_CALL(). While the child is suspended, the calling
+ * coroutine takes on the status of the child. If ACE_ROUTINE_DIRECT_CALLS is
+ * set to 1, its delay is checked using the delay of the child, so that the
+ * CoroutineScheduler (and its TimerWheel) handles it as if the child was
+ * running in its place. See runActiveFrame(). Otherwise, a delaying child
+ * leaves the caller in the Yielding state, so that the child is polled on
+ * each iteration. Either way, the delay fields of the caller are not touched,
+ * so the period of a COROUTINE_EVERY() in the caller is kept across the call.
  *
- * If you need to wait for longer than that, use a for-loop to call
- * COROUTINE_DELAY() as many times as necessary.
+ * The child is not scheduled by itself, and its mScheduler is not set, so a
+ * COROUTINE_WAIT_EVENT() or COROUTINE_JOIN() within the child polls on each
+ * call instead of parking.
+ */
+#define COROUTINE_CALL(child) \
+    do { \
+      this->startCall(child); \
+      while (!this->resumeCall(child)) { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Yield for delayMillis. A delayMillis of 0 is functionally equivalent to
+ * COROUTINE_YIELD(). To save memory, a delay up to 32767 milliseconds is
+ * stored as a uint16_t start time and duration. A longer delay, up to about
+ * 24 days, is stored as a 32-bit wake-up time in the same 4 bytes. See
+ * setDelayMillis().
  *
  * This could have been implemented using COROUTINE_AWAIT() but this macro
  * matches the global delay(millis) function already provided by the Arduino
@@ -216,7 +328,10 @@ extern className##_##name name
       this->setRunning(); \
     } while (false)
 
-/** Yield for delayMicros. Similiar to COROUTINE_DELAY(delayMillis). */
+/**
+ * Yield for delayMicros. Similiar to COROUTINE_DELAY(delayMillis). The longest
+ * delay is about 35 minutes.
+ */
 #define COROUTINE_DELAY_MICROS(delayMicros) \
     do { \
       this->setDelayMicros(delayMicros); \
@@ -228,7 +343,9 @@ extern className##_##name name
     } while (false)
 
 /**
- * Yield for delaySeconds. Similar to COROUTINE_DELAY(delayMillis).
+ * Yield for delaySeconds. Similar to COROUTINE_DELAY(delayMillis). The
+ * longest delay is limited by the rollover of the millis() clock to 4294967
+ * seconds (49.7 days).
  *
  * The accuracy of the delay interval in units of seconds is not perfectly
  * accurate. The current implementation uses the builtin millis() to infer the
@@ -252,6 +369,57 @@ extern className##_##name name
       this->setRunning(); \
     } while (false)
 
+/**
+ * Yield until the millisecond clock (i.e. `millis()`) reaches the absolute
+ * time `untilMillis`. If that time has already passed, this is equivalent to
+ * COROUTINE_YIELD(). The time can be up to INT32_MAX milliseconds (about 24.8
+ * days) in the future, the same limit as COROUTINE_DELAY(). A time further in
+ * the future is indistinguishable from a time in the past, because of the
+ * rollover of `millis()`.
+ */
+#define COROUTINE_DELAY_UNTIL(untilMillis) \
+    do { \
+      this->setDelayUntilMillis(untilMillis); \
+      this->setDelaying(); \
+      do { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } while (!this->isDelayExpired()); \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Yield until the next multiple of `periodMillis` after the previous
+ * COROUTINE_EVERY(), so that a loop containing this statement runs at a fixed
+ * rate without drifting, independent of the time spent in the loop and the
+ * lateness of the scheduler. The first call starts the period at the current
+ * time.
+ *
+ * If a whole period has been missed (the body of the loop, or the other
+ * coroutines, took too long), the missed periods are skipped to keep the
+ * phase. They are counted by Coroutine::getOverrunCount() if
+ * ACE_ROUTINE_OVERRUN_COUNT is set to 1.
+ *
+ * A coroutine should contain only a single COROUTINE_EVERY(), because any
+ * other COROUTINE_DELAY*(), COROUTINE_AWAIT_TIMEOUT() or
+ * COROUTINE_SELECT_TIMEOUT() overwrites the delay fields, and restarts the
+ * period from the current time. A COROUTINE_CALL() keeps the period, even if
+ * the child delays, because the child uses its own delay fields.
+ *
+ * The end of the previous period is stored in 16 bits, like the start of
+ * COROUTINE_DELAY(). If the coroutine does not run for 65536 milliseconds or
+ * more (e.g. it was suspended), the lateness wraps around: the overrun count
+ * misses the multiples of 65536 milliseconds, and the phase is shifted.
+ */
+#define COROUTINE_EVERY(periodMillis) \
+    do { \
+      this->setDelayEveryMillis(periodMillis); \
+      this->setDelaying(); \
+      do { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } while (!this->isDelayExpired()); \
+      this->setRunning(); \
+    } while (false)
+
 /**
  * Mark the end of a coroutine. Subsequent calls to Coroutine::runCoroutine()
  * will do nothing.
@@ -273,10 +441,35 @@ extern const __FlashStringHelper* const sStatusStrings[] PROGMEM;
 // Forward declaration of CoroutineSchedulerTemplate<T>
 template <typename T> class CoroutineSchedulerTemplate;
 
+// Forward declaration of TimerWheelBaseTemplate<T>
+template <typename T> class TimerWheelBaseTemplate;
+
+// Forward declaration of ThreadedCoroutineSchedulerTemplate<T>
+template <typename T> class ThreadedCoroutineSchedulerTemplate;
+
+// Forward declaration of EventTemplate<T>
+template <typename T> class EventTemplate;
+
+// Forward declaration of SchedulerStatsRendererTemplate<T>
+template <typename T> class SchedulerStatsRendererTemplate;
+
+// Forward declaration of MpmcChannelTemplate<T_COROUTINE, T, T_SIZE>
+template <typename T_COROUTINE, typename T, uint8_t T_SIZE>
+class MpmcChannelTemplate;
+
+namespace internal {
+// Forward declaration of StaticCoroutineEntry<T, T_INSTANCE>
+template <typename T, T* T_INSTANCE> struct StaticCoroutineEntry;
+}
+
 /**
  * Base class of all coroutines. The actual coroutine code is an implementation
  * of the virtual runCoroutine() method.
  *
+ * The internal::QueueNode base class allows the CoroutineScheduler to place the
+ * coroutine on its ready queue, or on a slot of a TimerWheel, and to move it
+ * between them in O(1).
+ *
  * @tparam T_CLOCK class that provides micros(), millis() and seconds()
  *    functions, usually `ClockInterface` but can be something else for testing
  *    purposes.
@@ -289,8 +482,18 @@ template <typename T> class CoroutineSchedulerTemplate;
  *    16-bits. I have not tested this possibility at all.
  */
 template <typename T_CLOCK, typename T_DELAY>
-class CoroutineTemplate {
+class CoroutineTemplate : public internal::QueueNode {
   friend class CoroutineSchedulerTemplate<CoroutineTemplate<T_CLOCK, T_DELAY>>;
+  friend class TimerWheelBaseTemplate<CoroutineTemplate<T_CLOCK, T_DELAY>>;
+  friend class ThreadedCoroutineSchedulerTemplate<
+      CoroutineTemplate<T_CLOCK, T_DELAY>>;
+  friend class EventTemplate<CoroutineTemplate<T_CLOCK, T_DELAY>>;
+  template <typename T_COROUTINE, typename T, uint8_t T_SIZE>
+  friend class MpmcChannelTemplate;
+  friend class SchedulerStatsRendererTemplate<
+      CoroutineTemplate<T_CLOCK, T_DELAY>>;
+  template <typename T, T* T_INSTANCE>
+  friend struct internal::StaticCoroutineEntry;
   friend class ::AceRoutineTest_statusStrings;
   friend class ::SuspendTest_suspendAndResume;
 
@@ -301,6 +504,15 @@ class CoroutineTemplate {
     /** Coroutine name is a `const __FlashStringHelper*` f-string. */
     static const uint8_t kNameTypeFString = 1;
 
+    /** Number of priority levels supported by the CoroutineScheduler. */
+    static const uint8_t kNumPriorities = 4;
+
+    /** Lowest and default priority. */
+    static const uint8_t kPriorityLowest = 0;
+
+    /** Highest priority. */
+    static const uint8_t kPriorityHighest = kNumPriorities - 1;
+
   public:
     /**
      * The body of the coroutine. The COROUTINE macro creates a subclass of
@@ -344,13 +556,42 @@ class CoroutineTemplate {
     int runCoroutineWithProfiler() {
       if (mProfiler) {
         uint32_t startMicros = coroutineMicros();
-        runCoroutine();
+        runActiveFrame();
         uint32_t elapsedMicros = coroutineMicros() - startMicros;
         mProfiler->updateElapsedMicros(elapsedMicros);
         return 0;
       } else {
-        return runCoroutine();
+        return runActiveFrame();
+      }
+    }
+
+    /**
+     * Run the innermost child of a COROUTINE_CALL() chain directly, instead of
+     * calling runCoroutine() of each coroutine in the chain, which would
+     * resume each one only to run its child. The status of the child is
+     * copied to this coroutine, and its delay is found by getDelayFrame(). If
+     * the innermost child is done, or there is no active COROUTINE_CALL(),
+     * this is the same as runCoroutine(), which lets the callers continue
+     * after their COROUTINE_CALL().
+     *
+     * Used by the CoroutineScheduler and runCoroutineWithProfiler(). Same as
+     * runCoroutine() unless ACE_ROUTINE_DIRECT_CALLS is set to 1.
+     */
+    int runActiveFrame() {
+#if ACE_ROUTINE_DIRECT_CALLS
+      if (mCallee != nullptr) {
+        CoroutineTemplate* frame = mCallee;
+        while (frame->mCallee != nullptr) frame = frame->mCallee;
+        if (! frame->isDone()) {
+          int result = frame->runCoroutine();
+          if (! frame->isDone()) {
+            copyCallStatus(*frame);
+            return result;
+          }
+        }
       }
+#endif
+      return runCoroutine();
     }
 
     /**
@@ -419,9 +660,34 @@ class CoroutineTemplate {
       }
     }
 
+    /** Return the scheduling priority of the coroutine. */
+    uint8_t getPriority() const { return mPriority; }
+
+    /**
+     * Set the scheduling priority of the coroutine, from kPriorityLowest (the
+     * default) to kPriorityHighest. The CoroutineScheduler always runs a ready
+     * coroutine of a higher priority before one of a lower priority, and
+     * round-robin within the same priority. A higher priority coroutine should
+     * therefore spend most of its time in a wait which removes it from the
+     * ready queue or is skipped by the scheduler: COROUTINE_DELAY*(),
+     * COROUTINE_WAIT_EVENT(), COROUTINE_JOIN(), COROUTINE_MPMC_READ() and
+     * COROUTINE_MPMC_WRITE(), or COROUTINE_QUEUE_POP(). A coroutine in
+     * COROUTINE_YIELD(), COROUTINE_AWAIT() (including the other channel
+     * macros, which are built on it) or COROUTINE_AWAIT_TIMEOUT() stays ready,
+     * and starves all lower priorities for as long as it waits.
+     *
+     * The new priority takes effect the next time the coroutine is placed on
+     * the ready queue, so it is best to call this before
+     * CoroutineScheduler::setup().
+     */
+    void setPriority(uint8_t priority) {
+      mPriority = (priority > kPriorityHighest) ? kPriorityHighest : priority;
+    }
+
     /**
-     * Suspend the coroutine at the next scheduler iteration. If the coroutine
-     * is already in the process of ending or is already terminated, then this
+     * Suspend the coroutine, and remove it from the ready queue (or the
+     * TimerWheel) of the CoroutineScheduler in O(1). If the coroutine is
+     * already in the process of ending or is already terminated, then this
      * method does nothing. A coroutine cannot use this method to suspend
      * itself, it can only suspend some other coroutine. Currently, there is no
      * ability for a coroutine to suspend itself. I think that would require the
@@ -432,13 +698,14 @@ class CoroutineTemplate {
     void suspend() {
       if (isDone()) return;
       mStatus = kStatusSuspended;
+      unlinkFromQueue();
     }
 
     /**
-     * Add a Suspended coroutine into the head of the scheduler linked list,
-     * and change the state to Yielding. If the coroutine is in any other
-     * state, this method does nothing. This method works only if the
-     * CoroutineScheduler::loop() is used.
+     * Add a Suspended coroutine to the back of the ready queue of its
+     * CoroutineScheduler, and change the state to Yielding. If the coroutine
+     * is in any other state, this method does nothing. This method works only
+     * if the CoroutineScheduler::loop() is used.
      */
     void resume() {
       if (mStatus != kStatusSuspended) return;
@@ -449,6 +716,7 @@ class CoroutineTemplate {
       // COROUTINE_DELAY() and COROUTINE_AWAIT() are written to restore their
       // status.
       mStatus = kStatusYielding;
+      makeReady();
     }
 
     /**
@@ -467,10 +735,22 @@ class CoroutineTemplate {
     void reset() {
       mStatus = kStatusYielding;
       mJumpPoint = nullptr;
+      mDelayType = kDelayTypeMillis;
+#if ACE_ROUTINE_DIRECT_CALLS
+      mCallee = nullptr;
+#endif
+
+      // A terminated, suspended or delaying coroutine must go back on the
+      // ready queue so that it restarts on the next iteration.
+      unlinkFromQueue();
+      makeReady();
     }
 
     /** Check if delay millis time is over. */
     bool isDelayExpired() const {
+      if (mDelayType & kDelayTypeLong) {
+        return isLongDelayExpired(coroutineMillis());
+      }
       T_DELAY nowMillis = coroutineMillis();
       T_DELAY elapsed = nowMillis - mDelayStart;
       return elapsed >= mDelayDuration;
@@ -478,6 +758,9 @@ class CoroutineTemplate {
 
     /** Check if delay micros time is over. */
     bool isDelayMicrosExpired() const {
+      if (mDelayType & kDelayTypeLong) {
+        return isLongDelayExpired(coroutineMicros());
+      }
       T_DELAY nowMicros = coroutineMicros();
       T_DELAY elapsed = nowMicros - mDelayStart;
       return elapsed >= mDelayDuration;
@@ -485,11 +768,85 @@ class CoroutineTemplate {
 
     /** Check if delay seconds time is over. */
     bool isDelaySecondsExpired() const {
+      if (mDelayType & kDelayTypeLong) {
+        return isLongDelayExpired(coroutineSeconds());
+      }
       T_DELAY nowSeconds = coroutineSeconds();
       T_DELAY elapsed = nowSeconds - mDelayStart;
       return elapsed >= mDelayDuration;
     }
 
+    /**
+     * Return the coroutine whose delay decides when this coroutine runs next:
+     * the innermost child of the active COROUTINE_CALL(), or this coroutine
+     * if there is none. Used by the TimerWheel. Always this coroutine unless
+     * ACE_ROUTINE_DIRECT_CALLS is set to 1.
+     */
+    const CoroutineTemplate* getDelayFrame() const {
+      const CoroutineTemplate* frame = this;
+#if ACE_ROUTINE_DIRECT_CALLS
+      while (frame->mCallee != nullptr) frame = frame->mCallee;
+#endif
+      return frame;
+    }
+
+    /**
+     * Check if the most recent delay is over, using the unit (millis, micros,
+     * seconds) of the COROUTINE_DELAY*() macro which set it. This allows the
+     * CoroutineScheduler and the TimerWheel to check a delay without calling
+     * runCoroutine().
+     */
+    bool isDelayTypeExpired() const {
+#if ACE_ROUTINE_DIRECT_CALLS
+      if (mCallee != nullptr) return getDelayFrame()->isDelayTypeExpired();
+#endif
+
+      switch (mDelayType & ~kDelayTypeLong) {
+        case kDelayTypeMicros:
+          return isDelayMicrosExpired();
+        case kDelayTypeSeconds:
+          return isDelaySecondsExpired();
+        default:
+          return isDelayExpired();
+      }
+    }
+
+    /**
+     * Return the number of microseconds until the most recent delay expires,
+     * or 0 if it has already expired. The result is rounded down to the
+     * resolution of the clock used by the delay, so that a caller which sleeps
+     * for this duration never wakes up after the delay has expired. A delay
+     * longer than about 4000 seconds is clamped.
+     */
+    uint32_t getDelayRemainingMicros() const {
+#if ACE_ROUTINE_DIRECT_CALLS
+      if (mCallee != nullptr) return getDelayFrame()->getDelayRemainingMicros();
+#endif
+      if (mDelayType & kDelayTypeLong) return getLongDelayRemainingMicros();
+
+      switch (mDelayType) {
+        case kDelayTypeMicros: {
+          T_DELAY elapsed = coroutineMicros() - mDelayStart;
+          return (elapsed >= mDelayDuration) ? 0 : mDelayDuration - elapsed;
+        }
+        case kDelayTypeSeconds: {
+          T_DELAY elapsed = coroutineSeconds() - mDelayStart;
+          if (elapsed >= mDelayDuration) return 0;
+          // The current second is partially elapsed, so count only the whole
+          // seconds, then poll each millisecond during the final second.
+          uint32_t seconds = mDelayDuration - elapsed - 1;
+          if (seconds > 4000) seconds = 4000;
+          return seconds * 1000000 + 1000;
+        }
+        default: {
+          T_DELAY elapsed = coroutineMillis() - mDelayStart;
+          if (elapsed >= mDelayDuration) return 0;
+          // The current millisecond is partially elapsed.
+          return (uint32_t) (mDelayDuration - elapsed - 1) * 1000 + 1;
+        }
+      }
+    }
+
     /** The coroutine was suspended with a call to suspend(). */
     bool isSuspended() const { return mStatus == kStatusSuspended; }
 
@@ -549,6 +906,44 @@ class CoroutineTemplate {
     /** Get the profiler. Nullable. */
     CoroutineProfiler* getProfiler() const { return mProfiler; }
 
+#if ACE_ROUTINE_DEADLINES
+    /**
+     * Set the deadline, which tracks the deadline misses of this coroutine
+     * and is used by the earliest-deadline-first mode of the
+     * CoroutineScheduler. Available only if ACE_ROUTINE_DEADLINES is set to 1.
+     */
+    void setDeadline(CoroutineDeadline* deadline) { mDeadline = deadline; }
+
+    /** Get the deadline. Nullable. */
+    CoroutineDeadline* getDeadline() const { return mDeadline; }
+#endif
+
+#if ACE_ROUTINE_OVERRUN_COUNT
+    /**
+     * Return the number of periods skipped by COROUTINE_EVERY() because the
+     * coroutine ran too late. A lateness of 65536 milliseconds or more is
+     * counted modulo 65536 milliseconds, see COROUTINE_EVERY(). Available only
+     * if ACE_ROUTINE_OVERRUN_COUNT is set to 1.
+     */
+    uint16_t getOverrunCount() const { return mOverrunCount; }
+
+    /** Set the overrun count to 0. */
+    void clearOverrunCount() { mOverrunCount = 0; }
+#endif
+
+#if ACE_ROUTINE_SCHEDULER_STATS
+    /**
+     * Return the number of times that the CoroutineScheduler called
+     * runCoroutine() and the coroutine did some work, i.e. excluding the calls
+     * which only found that its delay had not expired. Available only if
+     * ACE_ROUTINE_SCHEDULER_STATS is set to 1.
+     */
+    uint32_t getRunCount() const { return mRunCount; }
+
+    /** Set the run count to 0. */
+    void clearRunCount() { mRunCount = 0; }
+#endif
+
     /**
      * Get the pointer to the root pointer. Implemented as a function static to
      * fix the C++ static initialization problem, making it safe to use this in
@@ -625,6 +1020,31 @@ class CoroutineTemplate {
     /** Coroutine has ended and no longer in the scheduler queue. */
     static const Status kStatusTerminated = 5;
 
+    /** Unit of mDelayStart and mDelayDuration. */
+    typedef uint8_t DelayType;
+
+    /** Delay was set by COROUTINE_DELAY(). */
+    static const DelayType kDelayTypeMillis = 0;
+
+    /** Delay was set by COROUTINE_DELAY_MICROS(). */
+    static const DelayType kDelayTypeMicros = 1;
+
+    /** Delay was set by COROUTINE_DELAY_SECONDS(). */
+    static const DelayType kDelayTypeSeconds = 2;
+
+    /**
+     * Delay was set by COROUTINE_EVERY(). Same unit as kDelayTypeMillis, but
+     * the next COROUTINE_EVERY() starts from the end of this delay.
+     */
+    static const DelayType kDelayTypeEveryMillis = 3;
+
+    /**
+     * Flag added to kDelayTypeMillis, kDelayTypeMicros or kDelayTypeSeconds
+     * for a delay longer than 32767 units. The 32-bit wake-up time is stored
+     * in mDelayStart (lower 16 bits) and mDelayDuration (upper 16 bits).
+     */
+    static const DelayType kDelayTypeLong = 0x80;
+
     /** Constructor. Automatically insert self into singly-linked list. */
     CoroutineTemplate() {
       insertAtRoot();
@@ -674,64 +1094,259 @@ class CoroutineTemplate {
     /** Set the kStatusDelaying state. */
     void setDelaying() { mStatus = kStatusDelaying; }
 
-    /** Set the kStatusEnding state. */
-    void setEnding() { mStatus = kStatusEnding; }
+    /**
+     * Set the kStatusEnding state. The coroutines waiting in COROUTINE_JOIN()
+     * for this coroutine are made ready. They are parked only on the queue of
+     * joiners of the scheduler of this coroutine, so the state of other
+     * schedulers, which may run in other threads, is never touched. A
+     * coroutine without a CoroutineScheduler (e.g. one run by the
+     * ThreadedCoroutineScheduler) has no parked joiners. Nothing is parked
+     * unless ACE_ROUTINE_JOIN_PARKING is set to 1.
+     */
+    void setEnding() {
+      mStatus = kStatusEnding;
+#if ACE_ROUTINE_JOIN_PARKING
+      if (mScheduler == nullptr) return;
+
+      CoroutineQueueTemplate<CoroutineTemplate>& joiners =
+          mScheduler->mJoiners;
+      CoroutineTemplate* joiner = joiners.front();
+      while (joiner != nullptr) {
+        CoroutineTemplate* next = joiners.next(joiner);
+        if (joiner->mJoinTarget == this) {
+          joiner->unlinkFromQueue();
+          joiner->makeReady();
+        }
+        joiner = next;
+      }
+#endif
+    }
 
     /**
      * Set status to indicate that the Coroutine has been removed from the
-     * Scheduler queue. Should be used only by the CoroutineScheduler.
+     * Scheduler queue, and remove it from the queue. Should be used only by
+     * the CoroutineScheduler.
+     */
+    void setTerminated() {
+      mStatus = kStatusTerminated;
+      unlinkFromQueue();
+    }
+
+    /**
+     * Put this coroutine on the ready queue of its scheduler, if it has one
+     * and it is not already on a queue. A coroutine which is running is not on
+     * any queue, and is put back by the scheduler when it returns.
+     */
+    void makeReady() {
+      if (mScheduler != nullptr && ! isQueued()) {
+        mScheduler->readyCoroutine(this);
+      }
+    }
+
+    /**
+     * Used by COROUTINE_JOIN(). Return true if the target coroutine is done.
+     * Otherwise, park this coroutine on the queue of joiners of its scheduler
+     * (if ACE_ROUTINE_JOIN_PARKING is set to 1, and both coroutines are run
+     * by the same CoroutineScheduler) and return false.
+     */
+    bool join(const CoroutineTemplate& target) {
+      if (target.isDone()) return true;
+#if ACE_ROUTINE_JOIN_PARKING
+      if (mScheduler != nullptr && target.mScheduler == mScheduler) {
+        unlinkFromQueue();
+        mJoinTarget = &target;
+        mScheduler->mJoiners.pushBack(this);
+      }
+#endif
+      return false;
+    }
+
+    /**
+     * Used by COROUTINE_CALL(). Make the child the active callee of this
+     * coroutine, and reset it so that it starts from the beginning.
+     */
+    void startCall(CoroutineTemplate& child) {
+      child.reset();
+#if ACE_ROUTINE_DIRECT_CALLS
+      mCallee = &child;
+#endif
+    }
+
+    /**
+     * Used by COROUTINE_CALL(). Run the child if it is not done. Return true
+     * if it is done, which ends the call. Otherwise copy its status to this
+     * coroutine and return false.
+     */
+    bool resumeCall(CoroutineTemplate& child) {
+      if (! child.isDone()) child.runCoroutine();
+      if (child.isDone()) {
+#if ACE_ROUTINE_DIRECT_CALLS
+        mCallee = nullptr;
+#endif
+        return true;
+      }
+      copyCallStatus(child);
+      return false;
+    }
+
+    /**
+     * Copy the status of the callee to this coroutine. The delay fields are
+     * not copied, because they may hold the period of a COROUTINE_EVERY() of
+     * this coroutine. If ACE_ROUTINE_DIRECT_CALLS is set to 1, the delay of
+     * the callee is found by getDelayFrame() instead. Otherwise, a delaying
+     * callee leaves this coroutine in the Yielding state, so that the callee
+     * polls its own delay.
      */
-    void setTerminated() { mStatus = kStatusTerminated; }
+    void copyCallStatus(const CoroutineTemplate& callee) {
+#if ACE_ROUTINE_DIRECT_CALLS
+      mStatus = callee.mStatus;
+#else
+      mStatus = (callee.mStatus == kStatusDelaying)
+          ? kStatusYielding : callee.mStatus;
+#endif
+    }
 
     /**
      * Configure the delay timer for delayMillis.
      *
-     * The maximum duration is set to (UINT16_MAX / 2) (i.e. 32767
-     * milliseconds) if given a larger value. This makes the longest allowable
-     * time between two successive calls to isDelayExpired() for a given
-     * coroutine to be 32767 (UINT16_MAX - UINT16_MAX / 2 - 1) milliseconds,
-     * which should be long enough for all practical use-cases. (The '- 1'
-     * comes from an edge case where isDelayExpired() evaluates to be true in
-     * the CoroutineScheduler::runCoroutine() but becomes to be false in the
+     * A delay up to (UINT16_MAX / 2) (i.e. 32767 milliseconds) is stored as a
+     * 16-bit start time and duration. This makes the longest allowable time
+     * between two successive calls to isDelayExpired() for a given coroutine
+     * to be 32767 (UINT16_MAX - UINT16_MAX / 2 - 1) milliseconds, which should
+     * be long enough for all practical use-cases. (The '- 1' comes from an
+     * edge case where isDelayExpired() evaluates to be true in the
+     * CoroutineScheduler::runCoroutine() but becomes to be false in the
      * COROUTINE_DELAY() macro inside Coroutine::runCoroutine()) because the
      * clock increments by 1 millisecond.)
+     *
+     * A longer delay is stored as a 32-bit wake-up time in the same fields,
+     * see setDelay().
      */
-    void setDelayMillis(T_DELAY delayMillis) {
-      mDelayStart = coroutineMillis();
+    void setDelayMillis(uint32_t delayMillis) {
+      setDelay(kDelayTypeMillis, coroutineMillis(), delayMillis);
+    }
 
-      // If delayMillis is a compile-time constant, the compiler seems to
-      // completely optimize away this bounds checking code.
-      mDelayDuration = (delayMillis >= UINT16_MAX / 2)
-          ? UINT16_MAX / 2
-          : delayMillis;
+    /**
+     * Configure the delay timer to expire when the millisecond clock reaches
+     * `untilMillis`. A time in the past expires immediately.
+     */
+    void setDelayUntilMillis(uint32_t untilMillis) {
+      uint32_t nowMillis = coroutineMillis();
+      int32_t remaining = (int32_t) (untilMillis - nowMillis);
+      setDelay(kDelayTypeMillis, nowMillis, (remaining <= 0) ? 0 : remaining);
     }
 
     /**
-     * Configure the delay timer for delayMicros. Similar to seDelayMillis(),
-     * the maximum delay is 32767 micros.
+     * Configure the delay timer for the next period of COROUTINE_EVERY(). If
+     * the previous delay was also set by this method, the new delay starts
+     * when the previous one expired, instead of now, skipping the periods
+     * which have already passed. Otherwise, it starts now. The lateness is
+     * computed in T_DELAY, so it wraps around after 65536 milliseconds with
+     * the default uint16_t.
      */
-    void setDelayMicros(T_DELAY delayMicros) {
-      mDelayStart = coroutineMicros();
+    void setDelayEveryMillis(T_DELAY periodMillis) {
+      T_DELAY nowMillis = coroutineMillis();
+      if (periodMillis >= UINT16_MAX / 2) periodMillis = UINT16_MAX / 2;
+      if (periodMillis == 0) periodMillis = 1;
+
+      if (mDelayType == kDelayTypeEveryMillis) {
+        T_DELAY start = mDelayStart + mDelayDuration;
+        T_DELAY late = nowMillis - start;
+        if (late >= periodMillis) {
+          T_DELAY missed = late / periodMillis;
+#if ACE_ROUTINE_OVERRUN_COUNT
+          mOverrunCount += missed;
+#endif
+          start += missed * periodMillis;
+        }
+        mDelayStart = start;
+      } else {
+        mDelayType = kDelayTypeEveryMillis;
+        mDelayStart = nowMillis;
+      }
+      mDelayDuration = periodMillis;
+    }
 
-      // If delayMicros is a compile-time constant, the compiler seems to
-      // completely optimize away this bounds checking code.
-      mDelayDuration = (delayMicros >= UINT16_MAX / 2)
-          ? UINT16_MAX / 2
-          : delayMicros;
+    /**
+     * Configure the delay timer for delayMicros. Similar to seDelayMillis(),
+     * a delay longer than 32767 micros uses the 32-bit wake-up time.
+     */
+    void setDelayMicros(uint32_t delayMicros) {
+      setDelay(kDelayTypeMicros, coroutineMicros(), delayMicros);
     }
 
     /**
      * Configure the delay timer for delaySeconds. Similar to seDelayMillis(),
-     * the maximum delay is 32767 seconds.
+     * a delay longer than 32767 seconds uses the 32-bit wake-up time.
+     */
+    void setDelaySeconds(uint32_t delaySeconds) {
+      setDelay(kDelayTypeSeconds, coroutineSeconds(), delaySeconds);
+    }
+
+    /**
+     * Configure the delay timer of the given delayType, starting at `now`.
+     *
+     * A delay of at most (UINT16_MAX / 2) units keeps the 16-bit start time
+     * and duration, so the common case costs nothing extra. A longer delay
+     * sets the kDelayTypeLong flag and stores the 32-bit wake-up time (now +
+     * delay) in the same 4 bytes, so that it does not consume additional RAM.
+     * The longest delay is INT32_MAX units, limited by the signed comparison
+     * in isLongDelayExpired().
+     */
+    void setDelay(DelayType delayType, uint32_t now, uint32_t delay) {
+      // If delay is a compile-time constant, the compiler seems to completely
+      // optimize away the branch which is not taken.
+      if (delay <= UINT16_MAX / 2) {
+        mDelayType = delayType;
+        mDelayStart = now;
+        mDelayDuration = delay;
+      } else {
+        if (delay > (uint32_t) INT32_MAX) delay = INT32_MAX;
+        uint32_t wake = now + delay;
+        mDelayType = delayType | kDelayTypeLong;
+        mDelayStart = (uint16_t) wake;
+        mDelayDuration = (uint16_t) (wake >> 16);
+      }
+    }
+
+    /** Return the 32-bit wake-up time of a kDelayTypeLong delay. */
+    uint32_t getLongDelayWake() const {
+      return ((uint32_t) (uint16_t) mDelayDuration << 16)
+          | (uint16_t) mDelayStart;
+    }
+
+    /** Check if a kDelayTypeLong delay has expired at `now`. */
+    bool isLongDelayExpired(uint32_t now) const {
+      return (int32_t) (now - getLongDelayWake()) >= 0;
+    }
+
+    /**
+     * Return the number of micros remaining of a kDelayTypeLong delay, using
+     * the same clamping and rounding as getDelayRemainingMicros().
      */
-    void setDelaySeconds(T_DELAY delaySeconds) {
-      mDelayStart = coroutineSeconds();
+    uint32_t getLongDelayRemainingMicros() const {
+      switch (mDelayType & ~kDelayTypeLong) {
+        case kDelayTypeMicros: {
+          int32_t remaining = getLongDelayWake() - (uint32_t) coroutineMicros();
+          return (remaining <= 0) ? 0 : remaining;
+        }
+
+        case kDelayTypeSeconds: {
+          int32_t remaining =
+              getLongDelayWake() - (uint32_t) coroutineSeconds();
+          if (remaining <= 0) return 0;
+          uint32_t seconds = remaining - 1;
+          if (seconds > 4000) seconds = 4000;
+          return seconds * 1000000 + 1000;
+        }
 
-      // If delaySeconds is a compile-time constant, the compiler seems to
-      // completely optimize away this bounds checking code.
-      mDelayDuration = (delaySeconds >= UINT16_MAX / 2)
-          ? UINT16_MAX / 2
-          : delaySeconds;
+        default: {
+          int32_t remaining = getLongDelayWake() - (uint32_t) coroutineMillis();
+          if (remaining <= 0) return 0;
+          if (remaining > 4000000) remaining = 4000000;
+          return (uint32_t) (remaining - 1) * 1000 + 1;
+        }
+      }
     }
 
     /**
@@ -783,6 +1398,26 @@ class CoroutineTemplate {
     /** Pointer to the next coroutine in a singly-linked list. */
     CoroutineTemplate* mNext = nullptr;
 
+    /**
+     * The scheduler which owns the ready queue of this coroutine. Set by
+     * CoroutineScheduler::setup(). Nullable, e.g. when the coroutine is called
+     * directly from the global loop().
+     */
+    CoroutineSchedulerTemplate<CoroutineTemplate>* mScheduler = nullptr;
+
+#if ACE_ROUTINE_DIRECT_CALLS
+    /** The child running in COROUTINE_CALL(). Nullable. */
+    CoroutineTemplate* mCallee = nullptr;
+#endif
+
+#if ACE_ROUTINE_JOIN_PARKING
+    /**
+     * The coroutine waited for in COROUTINE_JOIN(). Valid only while this
+     * coroutine is parked on the queue of joiners of its scheduler.
+     */
+    const CoroutineTemplate* mJoinTarget = nullptr;
+#endif
+
     /** Address of the label used by the computed-goto. */
     void* mJumpPoint = nullptr;
 
@@ -798,6 +1433,15 @@ class CoroutineTemplate {
     /** Run-state of the coroutine. */
     Status mStatus = kStatusYielding;
 
+    /**
+     * Unit of mDelayStart and mDelayDuration, which allows the TimerWheel to
+     * check the delay without calling runCoroutine().
+     */
+    DelayType mDelayType = kDelayTypeMillis;
+
+    /** Scheduling priority, from kPriorityLowest to kPriorityHighest. */
+    uint8_t mPriority = kPriorityLowest;
+
     /**
      * Start time provided by COROUTINE_DELAY(), COROUTINE_DELAY_MICROS(), or
      * COROUTINE_DELAY_SECONDS(). The unit of this number is context dependent,
@@ -814,6 +1458,21 @@ class CoroutineTemplate {
 
     /** Pointer to a profiler instance, either static or on the heap. */
     CoroutineProfiler* mProfiler = nullptr;
+
+#if ACE_ROUTINE_DEADLINES
+    /** Pointer to an optional deadline instance. */
+    CoroutineDeadline* mDeadline = nullptr;
+#endif
+
+#if ACE_ROUTINE_OVERRUN_COUNT
+    /** Number of periods skipped by COROUTINE_EVERY(). */
+    uint16_t mOverrunCount = 0;
+#endif
+
+#if ACE_ROUTINE_SCHEDULER_STATS
+    /** Number of calls to runCoroutine() which did some work. */
+    uint32_t mRunCount = 0;
+#endif
 };
 
 /**
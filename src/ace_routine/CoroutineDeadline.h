@@ -0,0 +1,149 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_DEADLINE_H
+#define ACE_ROUTINE_COROUTINE_DEADLINE_H
+
+#include <stdint.h> // uint16_t, uint32_t
+
+/**
+ * Set to 1 to enable Coroutine::setDeadline() and the earliest-deadline-first
+ * mode of the CoroutineScheduler. Disabled by default, so that the code and
+ * the pointer to the CoroutineDeadline in each Coroutine are removed
+ * completely. It must be defined to the same value in every file which
+ * includes AceRoutine.h, e.g. using a compiler flag, or a `#define` before the
+ * `#include`.
+ */
+#ifndef ACE_ROUTINE_DEADLINES
+  #define ACE_ROUTINE_DEADLINES 0
+#endif
+
+namespace ace_routine {
+
+/**
+ * The relative deadline of a coroutine, and the counters which track how often
+ * the deadline was missed. An instance is attached to a coroutine using
+ * `Coroutine::setDeadline()`, in the same way as a CoroutineProfiler, and is
+ * updated by the CoroutineScheduler.
+ *
+ * Each time the coroutine becomes ready to run (e.g. its COROUTINE_DELAY()
+ * expired, or it was put back on the ready queue after a COROUTINE_YIELD()),
+ * the scheduler records the release time, and the absolute deadline becomes
+ * the release time plus the relative deadline. When the following call to
+ * `runCoroutine()` returns, the lateness is the current time minus the
+ * absolute deadline. If it is positive, the deadline was missed.
+ *
+ * The release time of a delaying coroutine is the expiration of its delay,
+ * computed using `Coroutine::getDelayRemainingMicros()`. It is exact for
+ * COROUTINE_DELAY_MICROS(), but may be early by up to 1 millisecond for
+ * COROUTINE_DELAY() and 1 second for COROUTINE_DELAY_SECONDS(), which
+ * overestimates the lateness by the same amount.
+ *
+ * When the scheduler is in earliest-deadline-first mode (see
+ * `CoroutineScheduler::setEarliestDeadlineFirst()`), the absolute deadline
+ * also determines the order in which the ready coroutines run.
+ */
+class CoroutineDeadline {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param relativeMicros deadline in microseconds after the coroutine
+     *    becomes ready to run
+     */
+    explicit CoroutineDeadline(uint32_t relativeMicros) :
+        mRelativeMicros(relativeMicros)
+    {}
+
+    /** Return the relative deadline in microseconds. */
+    uint32_t getRelativeMicros() const { return mRelativeMicros; }
+
+    /** Set the relative deadline in microseconds. */
+    void setRelativeMicros(uint32_t micros) { mRelativeMicros = micros; }
+
+    /**
+     * Return the absolute deadline, in units of `Coroutine::coroutineMicros()`,
+     * of the current release. Valid only if isReleased() is true.
+     */
+    uint32_t getAbsoluteMicros() const { return mAbsoluteMicros; }
+
+    /** Return true if the coroutine has been released but has not yet run. */
+    bool isReleased() const { return mReleased; }
+
+    /** Return the number of runs of the coroutine which were measured. */
+    uint32_t getRunCount() const { return mRunCount; }
+
+    /** Return the number of runs which completed after the deadline. */
+    uint32_t getMissCount() const { return mMissCount; }
+
+    /**
+     * Return the largest lateness in microseconds of the runs which missed the
+     * deadline, or 0 if none was missed.
+     */
+    uint32_t getWorstLatenessMicros() const { return mWorstLatenessMicros; }
+
+    /** Clear the counters. */
+    void clear() {
+      mRunCount = 0;
+      mMissCount = 0;
+      mWorstLatenessMicros = 0;
+    }
+
+    /**
+     * Record that the coroutine became ready to run at `nowMicros`. Called by
+     * the CoroutineScheduler.
+     */
+    void release(uint32_t nowMicros) {
+      mAbsoluteMicros = nowMicros + mRelativeMicros;
+      mReleased = true;
+    }
+
+    /**
+     * Record that the run of the coroutine completed at `nowMicros`, and
+     * update the counters. Called by the CoroutineScheduler.
+     */
+    void complete(uint32_t nowMicros) {
+      mReleased = false;
+      mRunCount++;
+      int32_t lateness = (int32_t) (nowMicros - mAbsoluteMicros);
+      if (lateness > 0) {
+        mMissCount++;
+        if ((uint32_t) lateness > mWorstLatenessMicros) {
+          mWorstLatenessMicros = lateness;
+        }
+      }
+    }
+
+  private:
+    uint32_t mRelativeMicros;
+    uint32_t mAbsoluteMicros = 0;
+    uint32_t mRunCount = 0;
+    uint32_t mMissCount = 0;
+    uint32_t mWorstLatenessMicros = 0;
+    bool mReleased = false;
+};
+
+}
+
+#endif
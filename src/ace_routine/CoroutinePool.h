@@ -0,0 +1,234 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_POOL_H
+#define ACE_ROUTINE_COROUTINE_POOL_H
+
+#include <stdint.h> // uint8_t
+#if defined(ARDUINO_ARCH_AVR)
+  #include <new.h> // placement new
+#else
+  #include <new> // placement new
+#endif
+#include "Coroutine.h"
+#include "CoroutineScheduler.h"
+
+namespace ace_routine {
+
+namespace internal {
+
+/**
+ * The coroutine of type `T` stored in a slot of a CoroutinePoolTemplate. It
+ * returns itself to the pool as soon as `T::runCoroutine()` finishes through
+ * COROUTINE_END().
+ *
+ * @tparam T_POOL type of the CoroutinePoolTemplate
+ * @tparam T type of the coroutine
+ */
+template <typename T_POOL, typename T>
+class PooledCoroutine : public T {
+  public:
+    /** Constructor. Passes the `args` to the constructor of `T`. */
+    template <typename... T_ARGS>
+    explicit PooledCoroutine(T_POOL* pool, const T_ARGS&... args) :
+        T(args...),
+        mPool(pool)
+    {}
+
+    /**
+     * Run the coroutine. When it reaches COROUTINE_END(), mark it as
+     * Terminated, so that the scheduler drops it, and return its slot to the
+     * pool.
+     */
+    int runCoroutine() override {
+      int result = T::runCoroutine();
+      if (this->isEnding()) {
+        this->setTerminated();
+        mPool->release(this);
+      }
+      return result;
+    }
+
+    /**
+     * Remove the coroutine from the singly-linked list of all coroutines, that
+     * the constructor inserted it into, and put it on the ready queue of the
+     * scheduler. The coroutine was inserted at the root, so this is O(1)
+     * unless the constructor of `T` created other coroutines.
+     */
+    template <typename T_SCHEDULER>
+    void start(T_SCHEDULER* scheduler) {
+      for (auto** p = T::getRoot(); (*p) != nullptr; p = (*p)->getNext()) {
+        if (*p == this) {
+          *p = this->mNext;
+          break;
+        }
+      }
+      this->mNext = nullptr;
+      this->mScheduler = scheduler;
+      this->makeReady();
+    }
+
+  private:
+    T_POOL* const mPool;
+};
+
+} // internal
+
+/**
+ * A fixed-size pool of coroutines of type `T`, created at runtime without the
+ * heap, for short-lived work such as one coroutine per incoming request. The
+ * storage of all the coroutines is a static array (the slab) inside the pool.
+ * The spawn() method constructs a coroutine in a free slot using placement
+ * new, and puts it directly on the ready queue of the scheduler. When the
+ * coroutine finishes through COROUTINE_END(), its slot is returned to the
+ * free list of the pool, so that it can be reused by the next spawn(). Both
+ * operations are O(1).
+ *
+ * The pooled coroutines are not in the singly-linked list of coroutines, so
+ * they are not visible to CoroutineScheduler::list() or
+ * CoroutineScheduler::setupCoroutines(), and they do not need to be removed
+ * from it. The destructor of `T` is called when the slot is reused, not when
+ * the coroutine ends, because the scheduler may still refer to the coroutine
+ * until runCoroutine() returns. A pooled coroutine must not be reset() after
+ * it has ended.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ * @tparam T subclass of `T_COROUTINE` which ends with COROUTINE_END()
+ * @tparam T_SIZE number of slots, at most 254
+ */
+template <typename T_COROUTINE, typename T, uint8_t T_SIZE>
+class CoroutinePoolTemplate {
+  static_assert(T_SIZE > 0 && T_SIZE < 255, "T_SIZE must be in [1, 254]");
+
+  public:
+    /** Type of the coroutine stored in each slot. */
+    using Slot = internal::PooledCoroutine<CoroutinePoolTemplate, T>;
+
+    /** Type of the scheduler. */
+    using Scheduler = CoroutineSchedulerTemplate<T_COROUTINE>;
+
+    /**
+     * Constructor.
+     *
+     * @param scheduler the scheduler which runs the spawned coroutines, or
+     *    nullptr (default) for the singleton used by the static methods of
+     *    CoroutineScheduler
+     */
+    explicit CoroutinePoolTemplate(Scheduler* scheduler = nullptr) :
+        mScheduler(scheduler)
+    {}
+
+    /**
+     * Construct a coroutine using `T(args...)` in a free slot and put it on
+     * the ready queue of the scheduler. Returns nullptr if all the slots are
+     * in use.
+     */
+    template <typename... T_ARGS>
+    T* spawn(const T_ARGS&... args) {
+      uint8_t index;
+      if (mFreeHead != kNoSlot) {
+        // Reuse a slot released by a coroutine which ended.
+        index = mFreeHead;
+        mFreeHead = mFreeNext[index];
+        Slot* old = slotAt(index);
+        old->unlinkFromQueue();
+        old->~Slot();
+      } else if (mNumConstructed < T_SIZE) {
+        // Use a slot which was never used.
+        index = mNumConstructed++;
+      } else {
+        return nullptr;
+      }
+
+      Slot* slot = new (mStorage[index]) Slot(this, args...);
+      mNumActive++;
+      slot->start(mScheduler ? mScheduler : Scheduler::getScheduler());
+      return slot;
+    }
+
+    /** Return the number of coroutines which have not ended yet. */
+    uint8_t getNumActive() const { return mNumActive; }
+
+    /** Return the number of slots. */
+    static uint8_t getCapacity() { return T_SIZE; }
+
+  private:
+    friend Slot;
+
+    /** Marks the end of the free list. */
+    static const uint8_t kNoSlot = 0xFF;
+
+    // Disable copy-constructor and assignment operator
+    CoroutinePoolTemplate(const CoroutinePoolTemplate&) = delete;
+    CoroutinePoolTemplate& operator=(const CoroutinePoolTemplate&) = delete;
+
+    Slot* slotAt(uint8_t index) {
+      return reinterpret_cast<Slot*>(mStorage[index]);
+    }
+
+    /** Return the slot of the coroutine which ended to the free list. */
+    void release(Slot* slot) {
+      uint8_t index = (reinterpret_cast<uint8_t*>(slot) - mStorage[0])
+          / sizeof(Slot);
+      mFreeNext[index] = mFreeHead;
+      mFreeHead = index;
+      mNumActive--;
+    }
+
+    /** Storage of the coroutines. */
+    alignas(Slot) uint8_t mStorage[T_SIZE][sizeof(Slot)];
+
+    /** Next slot in the free list, for each slot in the free list. */
+    uint8_t mFreeNext[T_SIZE];
+
+    /** First slot of the free list, or kNoSlot. */
+    uint8_t mFreeHead = kNoSlot;
+
+    /**
+     * Number of slots which have been constructed at least once. The slots
+     * at and above this index have never been used, and are not in the free
+     * list.
+     */
+    uint8_t mNumConstructed = 0;
+
+    /** Number of coroutines which have not ended. */
+    uint8_t mNumActive = 0;
+
+    /** Scheduler of the spawned coroutines. Nullable. */
+    Scheduler* const mScheduler;
+};
+
+/**
+ * CoroutinePoolTemplate using the default Coroutine class.
+ *
+ * @tparam T subclass of `Coroutine` which ends with COROUTINE_END()
+ * @tparam T_SIZE number of slots, at most 254
+ */
+template <typename T, uint8_t T_SIZE>
+using CoroutinePool = CoroutinePoolTemplate<Coroutine, T, T_SIZE>;
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_COROUTINE_QUEUE_H
+#define ACE_ROUTINE_COROUTINE_QUEUE_H
+
+#include <stdint.h> // uint16_t
+
+namespace ace_routine {
+
+template <typename T_COROUTINE> class CoroutineQueueTemplate;
+
+namespace internal {
+
+/**
+ * The links of a doubly-linked circular list. Each Coroutine inherits from this
+ * class, which allows a coroutine to be placed on exactly one queue at a time
+ * (e.g. the ready queue of the CoroutineScheduler, or a slot of a TimerWheel),
+ * and to be removed from that queue in O(1) without knowing which queue it is
+ * on.
+ *
+ * This is a separate list from the singly-linked list formed by
+ * `Coroutine::mNext`, which holds every coroutine that was ever constructed.
+ */
+class QueueNode {
+  template <typename T_COROUTINE>
+  friend class ace_routine::CoroutineQueueTemplate;
+
+  public:
+    /** Return true if this node is currently on a queue. */
+    bool isQueued() const { return mQueueNext != nullptr; }
+
+    /** Remove this node from its queue. Does nothing if it is not queued. */
+    void unlinkFromQueue() {
+      if (mQueueNext == nullptr) return;
+      mQueuePrev->mQueueNext = mQueueNext;
+      mQueueNext->mQueuePrev = mQueuePrev;
+      mQueueNext = nullptr;
+      mQueuePrev = nullptr;
+    }
+
+  protected:
+    QueueNode() = default;
+    ~QueueNode() = default;
+
+  private:
+    // Disable copy-constructor and assignment operator
+    QueueNode(const QueueNode&) = delete;
+    QueueNode& operator=(const QueueNode&) = delete;
+
+    /** Insert this node just before the given node. */
+    void insertBefore(QueueNode* node) {
+      mQueueNext = node;
+      mQueuePrev = node->mQueuePrev;
+      mQueuePrev->mQueueNext = this;
+      node->mQueuePrev = this;
+    }
+
+    QueueNode* mQueueNext = nullptr;
+    QueueNode* mQueuePrev = nullptr;
+};
+
+} // internal
+
+/**
+ * A FIFO queue of coroutines, implemented as an intrusive doubly-linked
+ * circular list with a sentinel head node. All operations are O(1). The queue
+ * does not own the coroutines, and never allocates memory.
+ *
+ * A coroutine can be on at most one queue at a time. Pushing a coroutine which
+ * is already on a queue is a programming error, so callers should check
+ * `Coroutine::isQueued()` or call `Coroutine::unlinkFromQueue()` first.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class CoroutineQueueTemplate {
+  public:
+    /** Constructor. Creates an empty queue. */
+    CoroutineQueueTemplate() {
+      mHead.mQueueNext = &mHead;
+      mHead.mQueuePrev = &mHead;
+    }
+
+    /** Return true if the queue contains no coroutines. */
+    bool isEmpty() const { return mHead.mQueueNext == &mHead; }
+
+    /** Return the coroutine at the front of the queue, or nullptr if empty. */
+    T_COROUTINE* front() const {
+      return isEmpty() ? nullptr : toCoroutine(mHead.mQueueNext);
+    }
+
+    /** Return the coroutine after `coroutine`, or nullptr at the end. */
+    T_COROUTINE* next(const T_COROUTINE* coroutine) const {
+      const internal::QueueNode* node = coroutine;
+      return (node->mQueueNext == &mHead)
+          ? nullptr
+          : toCoroutine(node->mQueueNext);
+    }
+
+    /** Append the coroutine to the back of the queue. */
+    void pushBack(T_COROUTINE* coroutine) {
+      coroutine->insertBefore(&mHead);
+    }
+
+    /** Insert the coroutine at the front of the queue. */
+    void pushFront(T_COROUTINE* coroutine) {
+      coroutine->insertBefore(mHead.mQueueNext);
+    }
+
+    /** Remove and return the front coroutine, or nullptr if empty. */
+    T_COROUTINE* popFront() {
+      if (isEmpty()) return nullptr;
+      T_COROUTINE* coroutine = toCoroutine(mHead.mQueueNext);
+      coroutine->unlinkFromQueue();
+      return coroutine;
+    }
+
+    /**
+     * Move all coroutines of `other` to the back of this queue, preserving
+     * their order. The `other` queue becomes empty.
+     */
+    void splice(CoroutineQueueTemplate& other) {
+      if (other.isEmpty()) return;
+      internal::QueueNode* first = other.mHead.mQueueNext;
+      internal::QueueNode* last = other.mHead.mQueuePrev;
+      first->mQueuePrev = mHead.mQueuePrev;
+      mHead.mQueuePrev->mQueueNext = first;
+      last->mQueueNext = &mHead;
+      mHead.mQueuePrev = last;
+      other.mHead.mQueueNext = &other.mHead;
+      other.mHead.mQueuePrev = &other.mHead;
+    }
+
+    /** Return the number of coroutines in the queue. O(N). */
+    uint16_t size() const {
+      uint16_t count = 0;
+      for (const internal::QueueNode* node = mHead.mQueueNext;
+          node != &mHead;
+          node = node->mQueueNext) {
+        count++;
+      }
+      return count;
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    CoroutineQueueTemplate(const CoroutineQueueTemplate&) = delete;
+    CoroutineQueueTemplate& operator=(const CoroutineQueueTemplate&) = delete;
+
+    static T_COROUTINE* toCoroutine(internal::QueueNode* node) {
+      return static_cast<T_COROUTINE*>(node);
+    }
+
+    /** Sentinel node. Its next is the front, its prev is the back. */
+    internal::QueueNode mHead;
+};
+
+}
+
+#endif
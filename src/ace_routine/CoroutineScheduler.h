@@ -28,8 +28,15 @@ SOFTWARE.
 #if ACE_ROUTINE_DEBUG == 1
   #include <Arduino.h> // Serial, Print
 #endif
+#include <stdint.h> // uint32_t, UINT32_MAX
 #include "Coroutine.h"
 #include "CoroutineProfiler.h"
+#include "CoroutineDeadline.h"
+#include "CoroutineQueue.h"
+#include "Event.h"
+#include "SchedulerStats.h"
+#include "StallWatchdog.h"
+#include "TimerWheel.h"
 
 class Print;
 
@@ -37,7 +44,8 @@ namespace ace_routine {
 
 /**
  * Class that manages instances of the `Coroutine` class, and executes them
- * in a round-robin fashion. This is expected to be used as a singleton.
+ * in a round-robin fashion. This is usually used as a singleton through its
+ * static methods, but independent instances can also be created.
  *
  * Design Notes:
  *
@@ -77,13 +85,131 @@ namespace ace_routine {
  * remove this extra layer of indirection. Fortunately, the none of these
  * methods are virtual, so the extra level of indirection consumes very little
  * overhead, even on 8-bit AVR processors.
+ *
+ * Eventually, the ability to run several independent schedulers (e.g. a fast
+ * one and a background one called at different rates, or one per thread on a
+ * Linux host) became useful. The constructor is now public, and each instance
+ * has its own singly-linked list of coroutines. A coroutine still inserts
+ * itself into the global list of the singleton when it is created, and
+ * addCoroutine() moves it to the list of another instance. The static methods
+ * continue to operate on the singleton, so existing code is unaffected.
+ *
+ * The scheduler now keeps its own ready queue of coroutines, separate from the
+ * singly-linked list of all coroutines. The ready queue is rebuilt from that
+ * list by setup(). Each call to loop() takes the coroutine at the front of the
+ * ready queue, runs it, and puts it at the back. Coroutine::suspend() and
+ * Coroutine::setTerminated() remove the coroutine from the ready queue, and
+ * Coroutine::resume() puts it back, so the cost of each pass depends only on
+ * the number of runnable coroutines. If a TimerWheel is attached
+ * using setTimerWheel(), a coroutine which returns through COROUTINE_DELAY() or
+ * COROUTINE_DELAY_SECONDS() is moved into the wheel instead, and moved back to
+ * the ready queue only when its delay has expired.
+ *
+ * The ready queue is actually one queue per priority level (see
+ * Coroutine::setPriority()), plus a bitmap of the levels which may be
+ * non-empty. Each call to loop() runs a coroutine from the highest non-empty
+ * level, so high priority coroutines never wait behind the lower priority
+ * ones. A delaying coroutine at a priority above the lowest is checked by the
+ * scheduler itself, and skipped if its delay has not expired, so that it does
+ * not starve the lower levels while it waits. At the lowest priority, every
+ * coroutine is run in round-robin order as before, and is responsible for
+ * checking its own delay.
+ *
+ * Since the scheduler knows which coroutines are ready and which are delaying,
+ * it can also compute how long the application may sleep before the next
+ * coroutine needs to run (getNextWakeupMicros()), instead of spinning through
+ * loop() at 100% CPU. The loopUntilIdle() method combines the two, calling an
+ * application-provided idle hook when there is nothing to do.
+ *
+ * Each call to loop() goes through getScheduler() and the Arduino loop()
+ * machinery to run a single coroutine. The runPass() and runFor() methods
+ * amortize that overhead by dispatching many coroutines in one call.
+ *
+ * Round-robin order within a priority level means that a coroutine whose
+ * deadline is about to expire can wait behind coroutines which have plenty of
+ * time left. A coroutine can be given a relative deadline by attaching a
+ * CoroutineDeadline, and setEarliestDeadlineFirst() then picks the ready
+ * coroutine with the nearest absolute deadline within each level. The
+ * CoroutineDeadline also counts the deadline misses, whether or not the
+ * earliest-deadline-first mode is enabled.
+ *
+ * If ACE_ROUTINE_SCHEDULER_STATS is set to 1, the scheduler also maintains a
+ * SchedulerStats (passes, dispatches, delay checks, idle time) and the run
+ * count of each coroutine, which are printed by the SchedulerStatsRenderer.
+ *
+ * A coroutine which runs for a long time without yielding delays every other
+ * coroutine. A StallWatchdog attached using setStallWatchdog() records the
+ * calls to runCoroutine() which take longer than its threshold.
  */
 template <typename T_COROUTINE>
 class CoroutineSchedulerTemplate {
+  // Allow resume() and reset() to put the coroutine on the ready queue.
+  friend T_COROUTINE;
+  // Allow an Event to add itself to the list of events of the scheduler.
+  friend class EventTemplate<T_COROUTINE>;
+
   public:
+    /**
+     * Function called by loopUntilIdle() when no coroutine is ready to run.
+     * The argument is the number of microseconds until the next coroutine
+     * needs to run, or kNoWakeup. The function may sleep for up to that
+     * duration, e.g. using `nanosleep()` on Linux or a low power mode on a
+     * microcontroller, and must return early if it is woken up by an
+     * interrupt which makes a coroutine ready.
+     */
+    typedef void (*IdleHook)(uint32_t micros);
+
+    /**
+     * Returned by getNextWakeupMicros() if no coroutine will become ready
+     * with the passage of time, for example when all coroutines are suspended.
+     */
+    static const uint32_t kNoWakeup = UINT32_MAX;
+
     /** Set up the scheduler. Should be called from the global setup(). */
     static void setup() { getScheduler()->setupScheduler(); }
 
+    /**
+     * Attach a TimerWheel to the scheduler, so that coroutines blocked in
+     * COROUTINE_DELAY() or COROUTINE_DELAY_SECONDS() are not polled on every
+     * iteration. This should be called before setup(). Passing nullptr
+     * detaches the wheel and returns to polling after the next setup().
+     */
+    static void setTimerWheel(TimerWheelBaseTemplate<T_COROUTINE>* wheel) {
+      getScheduler()->mTimerWheel = wheel;
+    }
+
+    /**
+     * Set the function to call from loopUntilIdle() when no coroutine is
+     * ready to run. Passing nullptr removes the hook.
+     */
+    static void setIdleHook(IdleHook hook) {
+      getScheduler()->mIdleHook = hook;
+    }
+
+#if ACE_ROUTINE_DEADLINES
+    /**
+     * Enable or disable the earliest-deadline-first mode. When enabled, the
+     * ready coroutines with a CoroutineDeadline (see Coroutine::setDeadline())
+     * run before the other coroutines of the same priority, in the order of
+     * their absolute deadlines. The coroutines without a deadline continue to
+     * run in round-robin order when none with a deadline is ready. Finding the
+     * earliest deadline is O(N) in the number of ready coroutines of the
+     * priority level. Available only if ACE_ROUTINE_DEADLINES is set to 1.
+     */
+    static void setEarliestDeadlineFirst(bool enable) {
+      getScheduler()->mEarliestDeadlineFirst = enable;
+    }
+#endif
+
+    /**
+     * Attach a StallWatchdog which checks the duration of every call to
+     * runCoroutine(). Passing nullptr detaches it.
+     */
+    static void setStallWatchdog(
+        StallWatchdogBaseTemplate<T_COROUTINE>* watchdog) {
+      getScheduler()->mStallWatchdog = watchdog;
+    }
+
     /** Set up the coroutines by calling their setupCoroutine() methods. */
     static void setupCoroutines() {
       getScheduler()->setupCoroutinesInternal();
@@ -97,6 +223,50 @@ class CoroutineSchedulerTemplate {
      */
     static void loop() { getScheduler()->runCoroutine(); }
 
+    /**
+     * Run one full pass through the coroutines which are ready when this is
+     * called, i.e. up to one dispatch for each ready coroutine, in scheduling
+     * order. This is equivalent to calling loop() that many times, but
+     * without the per-call overhead. The TimerWheel is checked once at the
+     * start of the pass, so a coroutine whose delay expires during the pass
+     * runs in the next pass.
+     */
+    static void runPass() { getScheduler()->runCoroutinePass(); }
+
+    /**
+     * Keep running passes through the ready coroutines, as in runPass(),
+     * until `micros` microseconds have elapsed. The clock is checked only
+     * after each pass, to keep the overhead per dispatch low, so the last pass
+     * may overrun the budget. If no coroutine is ready, this spins until the
+     * budget is used up, so loopUntilIdle() is a better choice for an
+     * application which wants to sleep.
+     */
+    static void runFor(uint32_t micros) {
+      getScheduler()->runCoroutinesFor(micros);
+    }
+
+    /**
+     * Run each coroutine which is currently ready once, then call the idle
+     * hook if no coroutine is ready anymore. This is intended to replace
+     * loop() in the global loop() function of applications which want to
+     * reduce their power or CPU consumption.
+     */
+    static void loopUntilIdle() { getScheduler()->runUntilIdle(); }
+
+    /**
+     * Return the number of microseconds until the next coroutine needs to
+     * run, 0 if a coroutine is ready to run now, or kNoWakeup if no coroutine
+     * will become ready with the passage of time. The result never exceeds the
+     * actual time until the next wakeup, so the caller can safely sleep for
+     * that duration.
+     *
+     * This visits every ready and delaying coroutine, so it is O(N), and
+     * should be called only when the application intends to sleep.
+     */
+    static uint32_t getNextWakeupMicros() {
+      return getScheduler()->nextWakeupMicros();
+    }
+
     /**
      * Run the current coroutine using the current scheduler with the coroutine
      * profiler enabled. This method returns when the underlying Coroutine
@@ -117,20 +287,101 @@ class CoroutineSchedulerTemplate {
       getScheduler()->listCoroutines(printer);
     }
 
-  private:
-    // Disable copy-constructor and assignment operator
-    CoroutineSchedulerTemplate(const CoroutineSchedulerTemplate&) = delete;
-    CoroutineSchedulerTemplate& operator=(const CoroutineSchedulerTemplate&) =
-        delete;
+#if ACE_ROUTINE_SCHEDULER_STATS
+    /** Return the SchedulerStats of the singleton scheduler. */
+    static const SchedulerStats& getStats() {
+      return getScheduler()->getSchedulerStats();
+    }
+
+    /**
+     * Clear the SchedulerStats of the singleton scheduler, and the run counts
+     * of its coroutines.
+     */
+    static void clearStats() { getScheduler()->clearSchedulerStats(); }
+#endif
 
-    /** Return the singleton CoroutineScheduler. */
+    /**
+     * Return the default singleton CoroutineScheduler, which is used by the
+     * static methods. Needed by classes which take a scheduler instance, e.g.
+     * CoroutinePool.
+     */
     static CoroutineSchedulerTemplate* getScheduler() {
-      static CoroutineSchedulerTemplate singletonScheduler;
+      static CoroutineSchedulerTemplate singletonScheduler(
+          T_COROUTINE::getRoot());
       return &singletonScheduler;
     }
 
-    /** Constructor. */
-    CoroutineSchedulerTemplate() = default;
+    /**
+     * Constructor of an independent scheduler instance, with its own list of
+     * coroutines, initially empty. Coroutines are moved into it using
+     * addCoroutine(). The instance is driven through its instance methods
+     * (e.g. setupScheduler(), runCoroutine(), runCoroutinePass()), not the
+     * static methods, which always refer to the default singleton scheduler.
+     */
+    CoroutineSchedulerTemplate() : mRootPtr(&mRoot) {}
+
+    /**
+     * Move the coroutine from the list of the scheduler which currently owns
+     * it (initially the default singleton scheduler) to the end of the list of
+     * this scheduler, so that coroutines run in the order that they were
+     * added. This should be called before setupScheduler(). It is O(N)
+     * because the lists are singly-linked.
+     */
+    void addCoroutine(T_COROUTINE& coroutine) {
+      T_COROUTINE** root = (coroutine.mScheduler != nullptr)
+          ? coroutine.mScheduler->mRootPtr
+          : T_COROUTINE::getRoot();
+      for (T_COROUTINE** p = root; (*p) != nullptr; p = (*p)->getNext()) {
+        if (*p == &coroutine) {
+          *p = coroutine.mNext;
+          break;
+        }
+      }
+      coroutine.unlinkFromQueue();
+
+      T_COROUTINE** p = mRootPtr;
+      while ((*p) != nullptr) p = (*p)->getNext();
+      *p = &coroutine;
+      coroutine.mNext = nullptr;
+      coroutine.mScheduler = this;
+    }
+
+    /** Instance version of setTimerWheel(). */
+    void attachTimerWheel(TimerWheelBaseTemplate<T_COROUTINE>* wheel) {
+      mTimerWheel = wheel;
+    }
+
+    /** Instance version of setIdleHook(). */
+    void attachIdleHook(IdleHook hook) {
+      mIdleHook = hook;
+    }
+
+#if ACE_ROUTINE_DEADLINES
+    /** Instance version of setEarliestDeadlineFirst(). */
+    void enableEarliestDeadlineFirst(bool enable) {
+      mEarliestDeadlineFirst = enable;
+    }
+#endif
+
+    /** Instance version of setStallWatchdog(). */
+    void attachStallWatchdog(StallWatchdogBaseTemplate<T_COROUTINE>* watchdog) {
+      mStallWatchdog = watchdog;
+    }
+
+#if ACE_ROUTINE_SCHEDULER_STATS
+    /** Instance version of getStats(). */
+    const SchedulerStats& getSchedulerStats() const { return mStats; }
+
+    /** Instance version of clearStats(). */
+    void clearSchedulerStats() {
+      mStats.clear(T_COROUTINE::coroutineMicros());
+      for (T_COROUTINE** p = mRootPtr;
+          (*p) != nullptr;
+          p = (*p)->getNext()) {
+        (*p)->clearRunCount();
+      }
+    }
+#endif
 
     /**
      * Set up the Scheduler.
@@ -141,19 +392,27 @@ class CoroutineSchedulerTemplate {
      * onwards, we keep all coroutines in the linked list no matter the state,
      * which makes the state management and linked-list management a lot
      * simpler.
+     *
+     * The ready queue is rebuilt from the linked list in the same order,
+     * skipping the coroutines which are Suspended or Terminated, so this
+     * method can be called again to pick up coroutines which were created
+     * after the previous call.
      */
     void setupScheduler() {
-      mCurrent = T_COROUTINE::getRoot();
-    }
-
-    /** Setup each coroutine by calling its setupCoroutine() function. */
-    void setupCoroutinesInternal() {
-      for (T_COROUTINE** p = T_COROUTINE::getRoot();
+      for (T_COROUTINE** p = mRootPtr;
           (*p) != nullptr;
           p = (*p)->getNext()) {
-
-        (*p)->setupCoroutine();
+        T_COROUTINE* coroutine = *p;
+        coroutine->mScheduler = this;
+        coroutine->unlinkFromQueue();
+        if (coroutine->isSuspended() || coroutine->isTerminated()) continue;
+        readyCoroutine(coroutine);
       }
+
+      if (mTimerWheel) mTimerWheel->setup();
+#if ACE_ROUTINE_SCHEDULER_STATS
+      mStats.clear(T_COROUTINE::coroutineMicros());
+#endif
     }
 
     /**
@@ -161,31 +420,218 @@ class CoroutineSchedulerTemplate {
      * Coroutine::runCoroutine().
      */
     void runCoroutine() {
-      // If reached the end, start from the beginning again.
-      if (*mCurrent == nullptr) {
-        mCurrent = T_COROUTINE::getRoot();
-        // Return if the list is empty. Checking for a null getRoot() inside the
-        // if-statement is deliberate, since it optimizes the common case where
-        // the linked list is not empty.
-        if (*mCurrent == nullptr) {
-          return;
+      T_COROUTINE* coroutine = nextCoroutine();
+#if ACE_ROUTINE_SCHEDULER_STATS
+      mStats.recordPass();
+      if (coroutine == nullptr) mStats.recordEmptyPass();
+#endif
+      if (coroutine == nullptr) return;
+      dispatchCoroutine(coroutine);
+    }
+
+    /*
+     * Run the current coroutine with profiling enabled by calling
+     * Coroutine::runCoroutineWithProfiler().
+     */
+    void runCoroutineWithProfiler() {
+      T_COROUTINE* coroutine = nextCoroutine();
+#if ACE_ROUTINE_SCHEDULER_STATS
+      mStats.recordPass();
+      if (coroutine == nullptr) mStats.recordEmptyPass();
+#endif
+      if (coroutine == nullptr) return;
+      dispatchCoroutine(coroutine, true /*withProfiler*/);
+    }
+
+    /**
+     * Dispatch each coroutine which is on the ready queues at the start of the
+     * pass at most once. The ready queues are moved to local queues in O(1),
+     * so a coroutine which is requeued or made ready during the pass goes
+     * onto the (now empty) ready queues, and runs in the next pass. The
+     * coroutines left on the local queues (e.g. delaying at a high priority)
+     * are moved back to the front of the ready queues at the end of the pass.
+     */
+    void runCoroutinePass() {
+      EventTemplate<T_COROUTINE>::drainPending(mEvents);
+      expireTimerWheel();
+
+      Queue passQueues[T_COROUTINE::kNumPriorities];
+      uint8_t passMask = mReadyMask;
+      for (uint8_t i = 0; i < T_COROUTINE::kNumPriorities; i++) {
+        passQueues[i].splice(mReadyQueues[i]);
+      }
+      mReadyMask = 0;
+
+      bool dispatched = false;
+      T_COROUTINE* coroutine;
+      while ((coroutine = popReadyCoroutine(passQueues, passMask)) != nullptr) {
+        dispatchCoroutine(coroutine);
+        dispatched = true;
+      }
+#if ACE_ROUTINE_SCHEDULER_STATS
+      mStats.recordPass();
+      if (! dispatched) mStats.recordEmptyPass();
+#else
+      (void) dispatched;
+#endif
+
+      for (uint8_t i = 0; i < T_COROUTINE::kNumPriorities; i++) {
+        if (passQueues[i].isEmpty()) continue;
+        passQueues[i].splice(mReadyQueues[i]);
+        mReadyQueues[i].splice(passQueues[i]);
+        mReadyMask |= (1 << i);
+      }
+    }
+
+    /** Instance version of runFor(). Runs passes until the budget is used. */
+    void runCoroutinesFor(uint32_t micros) {
+      uint32_t startMicros = T_COROUTINE::coroutineMicros();
+      do {
+        runCoroutinePass();
+      } while ((uint32_t) (T_COROUTINE::coroutineMicros() - startMicros)
+          < micros);
+    }
+
+    /**
+     * Run one pass of the ready coroutines, then call the idle hook if there
+     * is time to wait before the next coroutine becomes ready.
+     */
+    void runUntilIdle() {
+      runCoroutinePass();
+
+      if (mIdleHook == nullptr) return;
+      uint32_t micros = nextWakeupMicros();
+      if (micros == 0) return;
+#if ACE_ROUTINE_SCHEDULER_STATS
+      uint32_t startMicros = T_COROUTINE::coroutineMicros();
+      mIdleHook(micros);
+      mStats.recordIdle(T_COROUTINE::coroutineMicros() - startMicros);
+#else
+      mIdleHook(micros);
+#endif
+    }
+
+    /**
+     * Compute the time until the next wakeup, from the coroutines on the ready
+     * queues, then from the TimerWheel. A coroutine on a ready queue is ready
+     * now unless it is delaying. An Event notified since the last pass also
+     * makes a coroutine ready now.
+     */
+    uint32_t nextWakeupMicros() const {
+      if (EventTemplate<T_COROUTINE>::isAnyPending(mEvents)) return 0;
+
+      uint32_t next = kNoWakeup;
+      for (uint8_t i = 0; i < T_COROUTINE::kNumPriorities; i++) {
+        const Queue& queue = mReadyQueues[i];
+        for (T_COROUTINE* coroutine = queue.front();
+            coroutine != nullptr;
+            coroutine = queue.next(coroutine)) {
+          if (! coroutine->isDelaying()) return 0;
+          uint32_t remaining = coroutine->getDelayRemainingMicros();
+          if (remaining == 0) return 0;
+          if (remaining < next) next = remaining;
         }
       }
 
+      if (mTimerWheel) {
+        uint32_t remaining = mTimerWheel->getNextWakeupMicros();
+        if (remaining < next) next = remaining;
+      }
+      return next;
+    }
+
+    /**
+     * Return the root of the singly-linked list of the coroutines owned by
+     * this scheduler, to be iterated using Coroutine::getNext(). This is
+     * Coroutine::getRoot() for the default singleton scheduler. Coroutines
+     * spawned by a CoroutinePool are not in any list.
+     */
+    T_COROUTINE** getRoot() const { return mRootPtr; }
+
+    /** List all the routines in the linked list to the printer. */
+    void listCoroutines(Print& printer) {
+      for (T_COROUTINE** p = mRootPtr; (*p) != nullptr;
+          p = (*p)->getNext()) {
+        printer.print(F("Coroutine "));
+        (*p)->printNameTo(printer);
+        printer.print(F("; status: "));
+        (*p)->statusPrintTo(printer);
+        printer.println();
+      }
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    CoroutineSchedulerTemplate(const CoroutineSchedulerTemplate&) = delete;
+    CoroutineSchedulerTemplate& operator=(const CoroutineSchedulerTemplate&) =
+        delete;
+
+    /** Queue of coroutines. */
+    using Queue = CoroutineQueueTemplate<T_COROUTINE>;
+
+    /**
+     * Constructor of the singleton scheduler, which uses the global list of
+     * coroutines that every coroutine inserts itself into when it is created.
+     */
+    explicit CoroutineSchedulerTemplate(T_COROUTINE** root) : mRootPtr(root) {}
+
+    /** Setup each coroutine by calling its setupCoroutine() function. */
+    void setupCoroutinesInternal() {
+      for (T_COROUTINE** p = mRootPtr;
+          (*p) != nullptr;
+          p = (*p)->getNext()) {
+
+        (*p)->setupCoroutine();
+      }
+    }
+
+    /**
+     * Run the coroutine which was removed from its ready queue according to
+     * its status, then put it back on the appropriate queue. If
+     * `withProfiler` is true, Coroutine::runCoroutineWithProfiler() is called
+     * to enable the profiler.
+     */
+    void dispatchCoroutine(T_COROUTINE* coroutine, bool withProfiler = false) {
       // Handle the coroutine's dispatch back to the last known internal status.
-      switch ((*mCurrent)->getStatus()) {
+      switch (coroutine->getStatus()) {
         case T_COROUTINE::kStatusYielding:
-        case T_COROUTINE::kStatusDelaying:
+        case T_COROUTINE::kStatusDelaying: {
           // The coroutine itself knows whether it is yielding or delaying, and
           // its continuation context determines whether to call
           // Coroutine::isDelayExpired(), Coroutine::isDelayMicrosExpired(), or
           // Coroutine::isDelaySecondsExpired().
-          (*mCurrent)->runCoroutine();
+#if ACE_ROUTINE_DEADLINES
+          CoroutineDeadline* deadline = runnableDeadline(coroutine);
+#endif
+#if ACE_ROUTINE_SCHEDULER_STATS
+          bool delayCheck = isDelayCheck(coroutine);
+#endif
+          uint32_t startMicros = mStallWatchdog
+              ? T_COROUTINE::coroutineMicros()
+              : 0;
+          if (withProfiler) {
+            coroutine->runCoroutineWithProfiler();
+          } else {
+            coroutine->runActiveFrame();
+          }
+#if ACE_ROUTINE_DEADLINES
+          if (deadline) {
+            deadline->complete(T_COROUTINE::coroutineMicros());
+          }
+#endif
+          if (mStallWatchdog) {
+            mStallWatchdog->check(coroutine,
+                T_COROUTINE::coroutineMicros() - startMicros);
+          }
+#if ACE_ROUTINE_SCHEDULER_STATS
+          recordDispatch(coroutine, delayCheck);
+#endif
           break;
+        }
 
         case T_COROUTINE::kStatusEnding:
-          // mark it terminated
-          (*mCurrent)->setTerminated();
+          // mark it terminated, which removes it from the ready queue
+          coroutine->setTerminated();
           break;
 
         default:
@@ -193,70 +639,254 @@ class CoroutineSchedulerTemplate {
           break;
       }
 
-      // Go to the next coroutine
-      mCurrent = (*mCurrent)->getNext();
+      requeueCoroutine(coroutine);
     }
 
-    /*
-     * Run the current coroutine with profiling enabled by calling
-     * Coroutine::runCoroutineWithProfiler().
+    /**
+     * Return the next coroutine to run, removed from its ready queue, after
+     * moving any notified coroutines from the Events, and any expired
+     * coroutines from the TimerWheel, to the ready queues.
+     * Returns nullptr if no coroutine is ready.
+     *
+     * The priority levels above the lowest are searched from the highest
+     * down, using the bitmap to skip the empty ones. Within a level, the first
+     * coroutine which is not waiting on an unexpired delay is chosen, or in
+     * the earliest-deadline-first mode, the one with the nearest deadline. If
+     * none is found, the front of the lowest level is returned, or nullptr if
+     * that is also empty.
      */
-    void runCoroutineWithProfiler() {
-      // If reached the end, start from the beginning again.
-      if (*mCurrent == nullptr) {
-        mCurrent = T_COROUTINE::getRoot();
-        // Return if the list is empty. Checking for a null getRoot() inside the
-        // if-statement is deliberate, since it optimizes the common case where
-        // the linked list is not empty.
-        if (*mCurrent == nullptr) {
-          return;
+    T_COROUTINE* nextCoroutine() {
+      EventTemplate<T_COROUTINE>::drainPending(mEvents);
+      expireTimerWheel();
+      return popReadyCoroutine(mReadyQueues, mReadyMask);
+    }
+
+    /**
+     * Remove and return the next coroutine to run from the given array of
+     * queues (one per priority) and its bitmap of non-empty levels, without
+     * checking the TimerWheel.
+     */
+    T_COROUTINE* popReadyCoroutine(Queue* readyQueues, uint8_t& readyMask) {
+      for (uint8_t priority = T_COROUTINE::kPriorityHighest;
+          priority > T_COROUTINE::kPriorityLowest;
+          priority--) {
+        uint8_t bit = 1 << priority;
+        if ((readyMask & bit) == 0) continue;
+
+        Queue& queue = readyQueues[priority];
+#if ACE_ROUTINE_DEADLINES
+        if (mEarliestDeadlineFirst) {
+          T_COROUTINE* coroutine = findEarliestDeadline(queue);
+          if (coroutine != nullptr) {
+            coroutine->unlinkFromQueue();
+            return coroutine;
+          }
+        }
+#endif
+        for (T_COROUTINE* coroutine = queue.front();
+            coroutine != nullptr;
+            coroutine = queue.next(coroutine)) {
+          if (coroutine->isDelaying() && ! coroutine->isDelayTypeExpired()) {
+            continue;
+          }
+          coroutine->unlinkFromQueue();
+          return coroutine;
         }
+
+        // Coroutines can leave a queue through Coroutine::unlinkFromQueue()
+        // without the scheduler knowing, so the bit is cleared lazily here.
+        if (queue.isEmpty()) readyMask &= ~bit;
       }
 
-      // Handle the coroutine's dispatch back to the last known internal status.
-      switch ((*mCurrent)->getStatus()) {
-        case T_COROUTINE::kStatusYielding:
-        case T_COROUTINE::kStatusDelaying:
-          // The coroutine itself knows whether it is yielding or delaying, and
-          // its continuation context determines whether to call
-          // Coroutine::isDelayExpired(), Coroutine::isDelayMicrosExpired(), or
-          // Coroutine::isDelaySecondsExpired().
-          //
-          // This version calls `Coroutine::runCoroutineWithProfiler()` to
-          // enable the profiler.
-          (*mCurrent)->runCoroutineWithProfiler();
-          break;
+      Queue& lowest = readyQueues[T_COROUTINE::kPriorityLowest];
+#if ACE_ROUTINE_DEADLINES
+      if (mEarliestDeadlineFirst) {
+        T_COROUTINE* coroutine = findEarliestDeadline(lowest);
+        if (coroutine != nullptr) {
+          coroutine->unlinkFromQueue();
+          return coroutine;
+        }
+      }
+#endif
+      return lowest.popFront();
+    }
 
-        case T_COROUTINE::kStatusEnding:
-          // mark it terminated
-          (*mCurrent)->setTerminated();
-          break;
+#if ACE_ROUTINE_DEADLINES
 
-        default:
-          // For all other cases, just skip to the next coroutine.
-          break;
+    /**
+     * Return the coroutine in the queue with the nearest absolute deadline,
+     * ignoring the coroutines without a CoroutineDeadline and those waiting on
+     * an unexpired delay. Returns nullptr if there is none.
+     */
+    T_COROUTINE* findEarliestDeadline(const Queue& queue) {
+      T_COROUTINE* earliest = nullptr;
+      uint32_t earliestMicros = 0;
+      for (T_COROUTINE* coroutine = queue.front();
+          coroutine != nullptr;
+          coroutine = queue.next(coroutine)) {
+        CoroutineDeadline* deadline = runnableDeadline(coroutine);
+        if (deadline == nullptr) continue;
+
+        // Compare using the difference, to handle the rollover of micros().
+        uint32_t absoluteMicros = deadline->getAbsoluteMicros();
+        if (earliest == nullptr
+            || (int32_t) (absoluteMicros - earliestMicros) < 0) {
+          earliest = coroutine;
+          earliestMicros = absoluteMicros;
+        }
       }
+      return earliest;
+    }
 
-      // Go to the next coroutine
-      mCurrent = (*mCurrent)->getNext();
+    /**
+     * Return the CoroutineDeadline of the coroutine if it has one and the
+     * coroutine is ready to run now, i.e. it is not waiting on an unexpired
+     * delay. Returns nullptr otherwise.
+     */
+    static CoroutineDeadline* runnableDeadline(T_COROUTINE* coroutine) {
+      CoroutineDeadline* deadline = coroutine->getDeadline();
+      if (deadline == nullptr || ! deadline->isReleased()) return nullptr;
+      if (coroutine->isDelaying() && ! coroutine->isDelayTypeExpired()) {
+        return nullptr;
+      }
+      return deadline;
     }
 
-    /** List all the routines in the linked list to the printer. */
-    void listCoroutines(Print& printer) {
-      for (T_COROUTINE** p = T_COROUTINE::getRoot(); (*p) != nullptr;
-          p = (*p)->getNext()) {
-        printer.print(F("Coroutine "));
-        (*p)->printNameTo(printer);
-        printer.print(F("; status: "));
-        (*p)->statusPrintTo(printer);
-        printer.println();
+    /**
+     * Record the release time of the CoroutineDeadline of the coroutine, if
+     * it has one. A coroutine which is still delaying (i.e. polled on the
+     * ready queue instead of the TimerWheel) is released when its delay
+     * expires.
+     */
+    static void releaseDeadline(T_COROUTINE* coroutine) {
+      CoroutineDeadline* deadline = coroutine->getDeadline();
+      if (deadline == nullptr) return;
+      uint32_t releaseMicros = T_COROUTINE::coroutineMicros();
+      if (coroutine->isDelaying()) {
+        releaseMicros += coroutine->getDelayRemainingMicros();
+      }
+      deadline->release(releaseMicros);
+    }
+#endif
+
+#if ACE_ROUTINE_SCHEDULER_STATS
+    /**
+     * Return true if the coroutine is in COROUTINE_DELAY*() and its delay has
+     * not expired, so that runCoroutine() will only check the delay.
+     */
+    static bool isDelayCheck(T_COROUTINE* coroutine) {
+      return coroutine->isDelaying() && ! coroutine->isDelayTypeExpired();
+    }
+
+    /** Update the stats and the run count after runCoroutine(). */
+    void recordDispatch(T_COROUTINE* coroutine, bool delayCheck) {
+      mStats.recordDispatch(delayCheck);
+      if (! delayCheck) coroutine->mRunCount++;
+    }
+#endif
+
+    /** Move the expired coroutines from the TimerWheel to the ready queues. */
+    void expireTimerWheel() {
+      if (mTimerWheel == nullptr) return;
+
+      Queue expired;
+      mTimerWheel->expire(expired);
+      T_COROUTINE* coroutine;
+      while ((coroutine = expired.popFront()) != nullptr) {
+        readyCoroutine(coroutine);
+      }
+    }
+
+    /**
+     * Put the coroutine back after runCoroutine(). A Suspended or Terminated
+     * coroutine is dropped, and a coroutine which was already put on a queue
+     * during runCoroutine() (e.g. by reset()) is left alone. A delaying
+     * coroutine goes into the TimerWheel if one is attached and the wheel
+     * accepts it. Everything else goes to the back of the ready queue.
+     */
+    void requeueCoroutine(T_COROUTINE* coroutine) {
+      if (coroutine->isQueued()
+          || coroutine->isSuspended()
+          || coroutine->isTerminated()) {
+        return;
+      }
+      if (mTimerWheel
+          && coroutine->isDelaying()
+          && mTimerWheel->add(coroutine)) {
+        return;
       }
+      readyCoroutine(coroutine);
+    }
+
+    /**
+     * Put the coroutine at the back of the ready queue of its priority, and
+     * record the release time of its CoroutineDeadline if it has one.
+     */
+    void readyCoroutine(T_COROUTINE* coroutine) {
+#if ACE_ROUTINE_DEADLINES
+      releaseDeadline(coroutine);
+#endif
+      uint8_t priority = coroutine->getPriority();
+      mReadyQueues[priority].pushBack(coroutine);
+      mReadyMask |= (1 << priority);
     }
 
-    // The current coroutine is represented by a pointer to a pointer. This
-    // allows the root node to be treated the same as all the other nodes, and
-    // simplifies the code that traverses the singly-linked list.
-    T_COROUTINE** mCurrent = nullptr;
+    /**
+     * Coroutines which are eligible to run, one queue per priority level, each
+     * in round-robin order.
+     */
+    Queue mReadyQueues[T_COROUTINE::kNumPriorities];
+
+    /**
+     * Bit N is set if mReadyQueues[N] may be non-empty. A cleared bit means
+     * that the queue is definitely empty.
+     */
+    uint8_t mReadyMask = 0;
+
+    /**
+     * Events which the coroutines of this scheduler wait on, drained on each
+     * pass. Each Event adds itself when a coroutine of this scheduler first
+     * waits on it.
+     */
+    EventTemplate<T_COROUTINE>* mEvents = nullptr;
+
+#if ACE_ROUTINE_JOIN_PARKING
+    /**
+     * Coroutines parked in COROUTINE_JOIN(), waiting for another coroutine of
+     * this scheduler to end. Each one records its target in
+     * Coroutine::mJoinTarget.
+     */
+    Queue mJoiners;
+#endif
+
+    /** Optional timer wheel which holds the delaying coroutines. Nullable. */
+    TimerWheelBaseTemplate<T_COROUTINE>* mTimerWheel = nullptr;
+
+    /** Optional function called by loopUntilIdle(). Nullable. */
+    IdleHook mIdleHook = nullptr;
+
+    /** Optional watchdog of the duration of runCoroutine(). Nullable. */
+    StallWatchdogBaseTemplate<T_COROUTINE>* mStallWatchdog = nullptr;
+
+#if ACE_ROUTINE_DEADLINES
+    /** Run the ready coroutine with the nearest deadline first. */
+    bool mEarliestDeadlineFirst = false;
+#endif
+
+#if ACE_ROUTINE_SCHEDULER_STATS
+    /** Counters of the activity of the scheduler. */
+    SchedulerStats mStats;
+#endif
+
+    /**
+     * Pointer to the head of the singly-linked list of coroutines managed by
+     * this scheduler. Points to Coroutine::getRoot() for the singleton, and to
+     * mRoot for the other instances.
+     */
+    T_COROUTINE** const mRootPtr;
+
+    /** Head of the list of coroutines added using addCoroutine(). */
+    T_COROUTINE* mRoot = nullptr;
 };
 
 using CoroutineScheduler = CoroutineSchedulerTemplate<Coroutine>;
@@ -0,0 +1,297 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_CRTP_COROUTINE_H
+#define ACE_ROUTINE_CRTP_COROUTINE_H
+
+#include <stdint.h> // uint8_t, uint16_t, UINT16_MAX
+#include "ClockInterface.h"
+
+/**
+ * Create a CrtpCoroutine instance named 'name'. The code in {} following this
+ * macro becomes the body of the non-virtual runCoroutine() method. The same
+ * COROUTINE_BEGIN(), COROUTINE_LOOP(), COROUTINE_YIELD(), COROUTINE_AWAIT(),
+ * COROUTINE_DELAY*() and COROUTINE_END() macros are used inside the body.
+ */
+#define CRTP_COROUTINE(name) \
+struct CrtpCoroutine_##name : \
+    ace_routine::CrtpCoroutine<CrtpCoroutine_##name> { \
+  int runCoroutine(); \
+} name; \
+int CrtpCoroutine_##name :: runCoroutine()
+
+namespace ace_routine {
+
+namespace internal {
+// Forward declaration of StaticCoroutineEntry<T, T_INSTANCE>
+template <typename T, T* T_INSTANCE> struct StaticCoroutineEntry;
+}
+
+/**
+ * A devirtualized variant of CoroutineTemplate, using the Curiously Recurring
+ * Template Pattern. The subclass `T_DERIVED` provides a non-virtual
+ * `int runCoroutine()` method, and optionally a non-virtual
+ * `void setupCoroutine()` method, which are bound at compile time. The class
+ * has no virtual methods, so the instance carries no vtable pointer, and every
+ * call can be inlined by the compiler.
+ *
+ * It is meant to be paired with the StaticCoroutineScheduler, whose set of
+ * coroutines is also fixed at compile time:
+ *
+ * @code{.cpp}
+ * CRTP_COROUTINE(blink) { ... }
+ * CRTP_COROUTINE(print) { ... }
+ *
+ * using Scheduler = StaticCoroutineScheduler<
+ *     STATIC_COROUTINE(blink),
+ *     STATIC_COROUTINE(print)
+ * >;
+ * @endcode
+ *
+ * It can also be called directly from the global `loop()` using
+ * dispatchCoroutine().
+ *
+ * Only the state needed by the COROUTINE_*() macros is kept. The coroutine is
+ * not inserted into the linked list of all coroutines, and it cannot be used
+ * with the CoroutineScheduler, the TimerWheel, an Event, a CoroutinePool, a
+ * profiler or a deadline, all of which need the runtime dispatch of
+ * runCoroutine(). It has no name, and no priority. It contains only the jump
+ * point, the status and the 2 delay fields, without a vtable pointer (16 bytes
+ * on a 64-bit Linux host, instead of 88 bytes for a Coroutine).
+ *
+ * Unlike Coroutine, the delay is not extended by a 32-bit wake-up time, so
+ * COROUTINE_DELAY(), COROUTINE_DELAY_MICROS() and COROUTINE_DELAY_SECONDS()
+ * are limited to 32767 units. A longer delay is clamped to 32767.
+ *
+ * @tparam T_DERIVED the subclass which implements runCoroutine()
+ * @tparam T_CLOCK class that provides micros(), millis() and seconds()
+ *    functions, usually `ClockInterface`
+ * @tparam T_DELAY type used to store the mDelayStart and mDelayDuration,
+ *    usually `uint16_t`
+ */
+template <typename T_DERIVED, typename T_CLOCK, typename T_DELAY>
+class CrtpCoroutineTemplate {
+  template <typename T, T* T_INSTANCE>
+  friend struct internal::StaticCoroutineEntry;
+
+  public:
+    /**
+     * Default setupCoroutine() which does nothing. It is hidden, not
+     * overridden, by a setupCoroutine() method in the subclass.
+     */
+    void setupCoroutine() {}
+
+    /**
+     * Run the coroutine according to its status, using the same rules as the
+     * CoroutineScheduler: a Suspended or Terminated coroutine is skipped, and
+     * an Ending coroutine becomes Terminated. The call to
+     * `T_DERIVED::runCoroutine()` is statically bound.
+     */
+    void dispatchCoroutine() {
+      switch (mStatus) {
+        case kStatusYielding:
+        case kStatusDelaying:
+          static_cast<T_DERIVED*>(this)->runCoroutine();
+          break;
+
+        case kStatusEnding:
+          setTerminated();
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    /**
+     * Suspend the coroutine. If the coroutine is already in the process of
+     * ending or is already terminated, then this method does nothing.
+     */
+    void suspend() {
+      if (isDone()) return;
+      mStatus = kStatusSuspended;
+    }
+
+    /** Resume a Suspended coroutine. Otherwise, do nothing. */
+    void resume() {
+      if (mStatus != kStatusSuspended) return;
+      mStatus = kStatusYielding;
+    }
+
+    /** Reset the coroutine to its initial state. */
+    void reset() {
+      mStatus = kStatusYielding;
+      mJumpPoint = nullptr;
+    }
+
+    /** Check if delay millis time is over. */
+    bool isDelayExpired() const {
+      T_DELAY nowMillis = T_CLOCK::millis();
+      T_DELAY elapsed = nowMillis - mDelayStart;
+      return elapsed >= mDelayDuration;
+    }
+
+    /** Check if delay micros time is over. */
+    bool isDelayMicrosExpired() const {
+      T_DELAY nowMicros = T_CLOCK::micros();
+      T_DELAY elapsed = nowMicros - mDelayStart;
+      return elapsed >= mDelayDuration;
+    }
+
+    /** Check if delay seconds time is over. */
+    bool isDelaySecondsExpired() const {
+      T_DELAY nowSeconds = T_CLOCK::seconds();
+      T_DELAY elapsed = nowSeconds - mDelayStart;
+      return elapsed >= mDelayDuration;
+    }
+
+    /** The coroutine was suspended with a call to suspend(). */
+    bool isSuspended() const { return mStatus == kStatusSuspended; }
+
+    /** The coroutine returned using COROUTINE_YIELD(). */
+    bool isYielding() const { return mStatus == kStatusYielding; }
+
+    /** The coroutine returned using COROUTINE_DELAY(). */
+    bool isDelaying() const { return mStatus == kStatusDelaying; }
+
+    /** The coroutine is currently running. True only within the coroutine. */
+    bool isRunning() const { return mStatus == kStatusRunning; }
+
+    /** The coroutine returned using COROUTINE_END(). */
+    bool isEnding() const { return mStatus == kStatusEnding; }
+
+    /** The coroutine was terminated by the scheduler. */
+    bool isTerminated() const { return mStatus == kStatusTerminated; }
+
+    /** The coroutine is either Ending or Terminated. */
+    bool isDone() const {
+      return mStatus == kStatusEnding || mStatus == kStatusTerminated;
+    }
+
+  protected:
+    /** Same as CoroutineTemplate::Status. */
+    typedef uint8_t Status;
+
+    static const Status kStatusSuspended = 0;
+    static const Status kStatusYielding = 1;
+    static const Status kStatusDelaying = 2;
+    static const Status kStatusRunning = 3;
+    static const Status kStatusEnding = 4;
+    static const Status kStatusTerminated = 5;
+
+    /** Constructor. Does not insert self into any list. */
+    CrtpCoroutineTemplate() = default;
+
+    /** Destructor. Non-virtual. */
+    ~CrtpCoroutineTemplate() = default;
+
+    /** Return the status of the coroutine. */
+    Status getStatus() const { return mStatus; }
+
+    /** Pointer to label where execution will start on the next call. */
+    void setJump(void* jumpPoint) { mJumpPoint = jumpPoint; }
+
+    /** Pointer to label where execution will start on the next call. */
+    void* getJump() const { return mJumpPoint; }
+
+    /** Set the kStatusRunning state. */
+    void setRunning() { mStatus = kStatusRunning; }
+
+    /** Set the kStatusYielding state. */
+    void setYielding() { mStatus = kStatusYielding; }
+
+    /** Set the kStatusDelaying state. */
+    void setDelaying() { mStatus = kStatusDelaying; }
+
+    /** Set the kStatusEnding state. */
+    void setEnding() { mStatus = kStatusEnding; }
+
+    /** Set the kStatusTerminated state. */
+    void setTerminated() { mStatus = kStatusTerminated; }
+
+    /**
+     * Configure the delay timer for delayMillis. A delay longer than 32767 is
+     * clamped to 32767, before it is stored in T_DELAY.
+     */
+    void setDelayMillis(uint32_t delayMillis) {
+      mDelayStart = T_CLOCK::millis();
+      mDelayDuration = (delayMillis >= UINT16_MAX / 2)
+          ? UINT16_MAX / 2
+          : delayMillis;
+    }
+
+    /**
+     * Configure the delay timer for delayMicros. A delay longer than 32767 is
+     * clamped to 32767, before it is stored in T_DELAY.
+     */
+    void setDelayMicros(uint32_t delayMicros) {
+      mDelayStart = T_CLOCK::micros();
+      mDelayDuration = (delayMicros >= UINT16_MAX / 2)
+          ? UINT16_MAX / 2
+          : delayMicros;
+    }
+
+    /**
+     * Configure the delay timer for delaySeconds. A delay longer than 32767 is
+     * clamped to 32767, before it is stored in T_DELAY.
+     */
+    void setDelaySeconds(uint32_t delaySeconds) {
+      mDelayStart = T_CLOCK::seconds();
+      mDelayDuration = (delaySeconds >= UINT16_MAX / 2)
+          ? UINT16_MAX / 2
+          : delaySeconds;
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    CrtpCoroutineTemplate(const CrtpCoroutineTemplate&) = delete;
+    CrtpCoroutineTemplate& operator=(const CrtpCoroutineTemplate&) = delete;
+
+    /** Address of the label used by the computed-goto. */
+    void* mJumpPoint = nullptr;
+
+    /** Run-state of the coroutine. */
+    Status mStatus = kStatusYielding;
+
+    /** Start time of the COROUTINE_DELAY*() in its own unit. */
+    T_DELAY mDelayStart;
+
+    /** Delay time of the COROUTINE_DELAY*() in its own unit. */
+    T_DELAY mDelayDuration;
+};
+
+/**
+ * A CrtpCoroutineTemplate that uses the ClockInterface, in the same way as
+ * Coroutine.
+ *
+ * @tparam T_DERIVED the subclass which implements runCoroutine()
+ */
+template <typename T_DERIVED>
+using CrtpCoroutine =
+    CrtpCoroutineTemplate<T_DERIVED, ClockInterface, uint16_t>;
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_DEADLINE_TABLE_RENDERER_H
+#define ACE_ROUTINE_DEADLINE_TABLE_RENDERER_H
+
+#include <stdint.h> // uint8_t, uint32_t
+#include <Arduino.h> // Print
+#include "Coroutine.h" // Coroutine
+#include "CoroutineDeadline.h" // ACE_ROUTINE_DEADLINES
+#include "CoroutineScheduler.h" // CoroutineSchedulerTemplate
+#include "LogBinTableRenderer.h" // printUint32To()
+
+#if ACE_ROUTINE_DEADLINES
+
+namespace ace_routine {
+
+/**
+ * Print the counters of the CoroutineDeadline of each Coroutine in a
+ * human-readable table, in the same format as the LogBinTableRenderer, so
+ * that the two tables can be printed one after the other. Coroutines without
+ * a CoroutineDeadline are skipped. Available only if ACE_ROUTINE_DEADLINES is
+ * set to 1. For example:
+ *
+ * @verbatim
+ * name              runs    misses worst(us)
+ * control           1000         3       412
+ * display            100         0         0
+ * @endverbatim
+ *
+ * The coroutines are taken from the default singleton scheduler, from a
+ * given scheduler instance, or from an array of coroutines. The last is
+ * needed for the coroutines spawned by a CoroutinePool, which are not in the
+ * list of any scheduler.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class DeadlineTableRendererTemplate {
+  public:
+    /** Type of the scheduler. */
+    using Scheduler = CoroutineSchedulerTemplate<T_COROUTINE>;
+
+    /**
+     * Print the counters of the deadlines of the coroutines of the default
+     * singleton scheduler.
+     *
+     * @param printer destination of output, usually `Serial`
+     * @param clear call CoroutineDeadline::clear() after printing
+     *        (default true)
+     */
+    static void printTo(Print& printer, bool clear = true) {
+      printTo(printer, *Scheduler::getScheduler(), clear);
+    }
+
+    /**
+     * Print the counters of the deadlines of the coroutines owned by the
+     * given scheduler.
+     */
+    static void printTo(
+        Print& printer, const Scheduler& scheduler, bool clear = true) {
+      bool isHeaderPrinted = false;
+      for (T_COROUTINE** p = scheduler.getRoot(); (*p) != nullptr;
+          p = (*p)->getNext()) {
+        printRowTo(printer, **p, isHeaderPrinted, clear);
+      }
+    }
+
+    /**
+     * Print the counters of the deadlines of the `num` coroutines in the
+     * given array, e.g. the coroutines returned by CoroutinePool::spawn().
+     */
+    static void printTo(
+        Print& printer,
+        T_COROUTINE* const coroutines[],
+        uint8_t num,
+        bool clear = true) {
+      bool isHeaderPrinted = false;
+      for (uint8_t i = 0; i < num; i++) {
+        printRowTo(printer, *coroutines[i], isHeaderPrinted, clear);
+      }
+    }
+
+  private:
+    /**
+     * Print the counters of the deadline of the coroutine, preceded by the
+     * header if it was not printed yet. Does nothing if the coroutine has no
+     * deadline.
+     */
+    static void printRowTo(
+        Print& printer,
+        T_COROUTINE& coroutine,
+        bool& isHeaderPrinted,
+        bool clear) {
+      CoroutineDeadline* deadline = coroutine.getDeadline();
+      if (! deadline) return;
+
+      if (! isHeaderPrinted) {
+        printer.println(F("name              runs    misses worst(us)"));
+        isHeaderPrinted = true;
+      }
+
+      // Same 12-character name column as LogBinTableRenderer.
+      coroutine.printNameTo(printer, 12);
+      internal::printUint32To(printer, deadline->getRunCount(), 10);
+      internal::printUint32To(printer, deadline->getMissCount(), 10);
+      internal::printUint32To(printer, deadline->getWorstLatenessMicros(), 10);
+      printer.println();
+
+      if (clear) {
+        deadline->clear();
+      }
+    }
+};
+
+using DeadlineTableRenderer = DeadlineTableRendererTemplate<Coroutine>;
+
+} // namespace ace_routine
+
+#endif // ACE_ROUTINE_DEADLINES
+
+#endif
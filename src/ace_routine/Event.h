@@ -0,0 +1,270 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_EVENT_H
+#define ACE_ROUTINE_EVENT_H
+
+#include <stdint.h> // uint8_t
+#include "Coroutine.h"
+#include "CoroutineQueue.h"
+
+#if defined(EPOXY_DUINO)
+  #include <atomic>
+#endif
+
+/**
+ * Wait until the event is notified, then continue. If the event was already
+ * notified before this is reached, the coroutine continues immediately. The
+ * notification is consumed, so each notify() lets at most one waiting
+ * coroutine continue.
+ *
+ * When the coroutine is run by a CoroutineScheduler, it is removed from the
+ * ready queue while it waits, so unlike COROUTINE_AWAIT(), it consumes no CPU
+ * time until the event is notified. When the coroutine is called directly, or
+ * it is run by a scheduler other than the one of the first coroutine which
+ * waited on the event, the event is polled on each call.
+ */
+#define COROUTINE_WAIT_EVENT(event) \
+    do { \
+      this->setYielding(); \
+      while (!(event).consume(this)) { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+namespace ace_routine {
+
+namespace internal {
+
+#if defined(EPOXY_DUINO)
+
+/**
+ * A flag of EventTemplate which is set by notify() and cleared by the scheduler
+ * which owns the event. On a Linux or MacOS host, notify() may be called from a
+ * separate thread (e.g. the producer of an IsrQueue), so the flag is a
+ * std::atomic.
+ */
+class EventFlag {
+  public:
+    bool load() const { return mValue.load(); }
+
+    void store(bool value) { mValue.store(value); }
+
+  private:
+    std::atomic<bool> mValue{false};
+};
+
+#else
+
+/**
+ * A flag of EventTemplate which is set by notify() and cleared by the scheduler
+ * which owns the event. A single byte is read and written atomically on every
+ * microcontroller, so a volatile bool is enough to share it with an ISR.
+ */
+class EventFlag {
+  public:
+    bool load() const { return mValue; }
+
+    void store(bool value) { mValue = value; }
+
+  private:
+    volatile bool mValue = false;
+};
+
+#endif
+
+}
+
+/**
+ * An auto-reset event which allows coroutines to wait efficiently for
+ * something that happens rarely, e.g. an interrupt. A coroutine waits using
+ * COROUTINE_WAIT_EVENT(), and another coroutine or an interrupt service routine
+ * calls notify().
+ *
+ * notify() only sets a volatile flag, so it is lock-free and safe to call from
+ * an ISR (or from another thread on a Linux or MacOS host, where the flag is
+ * atomic). The event belongs to the CoroutineScheduler of the first coroutine
+ * which waits on it, which adds the event to its own list of events. Each
+ * pass of that scheduler checks the flag of each of its events (a single byte
+ * load per event). The notification of each notified event is cleared and
+ * handed to the first waiting coroutine, which is moved back to its ready
+ * queue, so the waiters continue in FIFO order and another coroutine cannot
+ * steal the notification before the waiter runs. Multiple calls to notify()
+ * before the notification is handed over are coalesced into one. If no
+ * coroutine is waiting, the notification remains pending until the next
+ * COROUTINE_WAIT_EVENT().
+ *
+ * An event should be a global or static object which is never destroyed, just
+ * like a Coroutine, because its scheduler keeps a pointer to it. A scheduler
+ * never touches the events of another scheduler, so each scheduler may run in
+ * its own thread on a Linux host. A coroutine of another scheduler which waits
+ * on the event polls it instead of parking, so it must run in the same thread
+ * as the scheduler which owns the event. Only notify() may be called from any
+ * thread. An event cannot be used with ThreadedCoroutineScheduler.
+ *
+ * If a coroutine which was handed a notification is suspended, terminated or
+ * reset() before it runs, the notification is returned to the event on the
+ * next pass of the scheduler, or when another coroutine waits on it. A reset()
+ * is detected because it clears the jump point of the coroutine, which was
+ * recorded when the notification was handed over.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class EventTemplate {
+  public:
+    /** Constructor. */
+    EventTemplate() {}
+
+    /**
+     * Notify the event, allowing one waiting coroutine to continue. Safe to
+     * call from an interrupt service routine.
+     */
+    void notify() {
+      mPending.store(true);
+    }
+
+    /**
+     * Return true if the event was notified but the notification was neither
+     * consumed nor handed to a waiting coroutine.
+     */
+    bool isPending() const { return mPending.load(); }
+
+    /**
+     * Used by COROUTINE_WAIT_EVENT(). Not designed to be used directly by the
+     * user. If the notification was handed to this coroutine, or if the event
+     * is pending and no other coroutine is waiting for it, consume it and
+     * return true. Otherwise, park the coroutine at the back of the wait queue
+     * of the event (if it is run by the CoroutineScheduler which owns the
+     * event) and return false.
+     */
+    bool consume(T_COROUTINE* coroutine) {
+      reclaimHandoff();
+      if (mHandoff == coroutine) {
+        mHandoff = nullptr;
+        return true;
+      }
+      if (mPending.load() && mHandoff == nullptr && mWaiters.isEmpty()) {
+        mPending.store(false);
+        return true;
+      }
+      if (coroutine->mScheduler == nullptr) return false;
+
+      if (mScheduler == nullptr) {
+        mScheduler = coroutine->mScheduler;
+        mNextEvent = mScheduler->mEvents;
+        mScheduler->mEvents = this;
+      }
+      if (coroutine->mScheduler == mScheduler) {
+        coroutine->unlinkFromQueue();
+        mWaiters.pushBack(coroutine);
+      }
+      return false;
+    }
+
+    /**
+     * Hand the notification of each pending event in the list which starts at
+     * 'events' to its first waiting coroutine, and move that coroutine to its
+     * ready queue. Called by the CoroutineScheduler once per pass, with its
+     * own list of events. An event hands over at most one notification at a
+     * time; a notify() which arrives before the waiter runs is handed to the
+     * next waiter after that.
+     */
+    static void drainPending(EventTemplate* events) {
+      for (EventTemplate* event = events;
+          event != nullptr;
+          event = event->mNextEvent) {
+        event->reclaimHandoff();
+        if (event->mHandoff != nullptr || ! event->mPending.load()) continue;
+        T_COROUTINE* coroutine = event->mWaiters.popFront();
+        if (coroutine == nullptr) continue;
+        event->mPending.store(false);
+        event->mHandoff = coroutine;
+        event->mHandoffJump = coroutine->getJump();
+        coroutine->makeReady();
+      }
+    }
+
+    /**
+     * Return true if an event in the list which starts at 'events' was
+     * notified and has a coroutine waiting for it, i.e. if the next
+     * drainPending() will make a coroutine ready.
+     */
+    static bool isAnyPending(const EventTemplate* events) {
+      for (const EventTemplate* event = events;
+          event != nullptr;
+          event = event->mNextEvent) {
+        if (event->mPending.load() && ! event->mWaiters.isEmpty()) return true;
+      }
+      return false;
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    EventTemplate(const EventTemplate&) = delete;
+    EventTemplate& operator=(const EventTemplate&) = delete;
+
+    /**
+     * Take back the notification which was handed to a waiting coroutine if
+     * that coroutine was suspended, terminated or reset() before it could
+     * run. It no longer waits at the jump point recorded at the hand-off.
+     */
+    void reclaimHandoff() {
+      if (mHandoff == nullptr) return;
+      if (! mHandoff->isSuspended() && ! mHandoff->isDone()
+          && mHandoff->getJump() == mHandoffJump) return;
+      mHandoff = nullptr;
+      mPending.store(true);
+    }
+
+    /**
+     * The scheduler of the first coroutine which waited on this event, which
+     * holds it in its list of events. Nullable.
+     */
+    CoroutineSchedulerTemplate<T_COROUTINE>* mScheduler = nullptr;
+
+    /** Next event in the list of events of mScheduler. */
+    EventTemplate* mNextEvent = nullptr;
+
+    /** Coroutines waiting for this event, in FIFO order. */
+    CoroutineQueueTemplate<T_COROUTINE> mWaiters;
+
+    /** The waiting coroutine which was handed the notification. */
+    T_COROUTINE* mHandoff = nullptr;
+
+    /** The jump point of mHandoff when it was handed the notification. */
+    void* mHandoffJump = nullptr;
+
+    /** Set by notify(), cleared when consumed or handed to a waiter. */
+    internal::EventFlag mPending;
+};
+
+/** EventTemplate using the default Coroutine class. */
+using Event = EventTemplate<Coroutine>;
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_GENERATOR_H
+#define ACE_ROUTINE_GENERATOR_H
+
+#include "Coroutine.h"
+#include "SubCoroutine.h"
+
+/**
+ * Yield the given value to the caller of Generator::next(), then continue
+ * from here on the next call. Can be used only within the runCoroutine() of a
+ * GeneratorTemplate.
+ */
+#define COROUTINE_YIELD_VALUE(value) \
+    do { \
+      this->setValue(value); \
+      this->setYielding(); \
+      COROUTINE_YIELD_INTERNAL(); \
+      this->setRunning(); \
+    } while (false)
+
+namespace ace_routine {
+
+/**
+ * A coroutine which lazily produces a sequence of values of type T. The
+ * subclass implements runCoroutine() using COROUTINE_YIELD_VALUE(v) to produce
+ * each value, and COROUTINE_END() at the end of the sequence. The consumer
+ * pulls each value using next(), which runs the generator just far enough to
+ * produce the next value.
+ *
+ * Unlike Channel, there is no handshake between the producer and the
+ * consumer, and the value is copied only once, directly into the variable of
+ * the consumer given to next().
+ *
+ * The generator can also use COROUTINE_YIELD(), COROUTINE_DELAY(), etc. while
+ * it waits for something, e.g. a sensor reading. In that case, next() returns
+ * false, and the consumer should try again later, for example:
+ *
+ * @code
+ * COROUTINE(consumer) {
+ *   static int value;
+ *   COROUTINE_LOOP() {
+ *     COROUTINE_AWAIT(generator.next(value) || generator.isDone());
+ *     if (generator.isDone()) break;
+ *     ...
+ *   }
+ * }
+ * @endcode
+ *
+ * A generator is a SubCoroutine, so it is not run by the CoroutineScheduler
+ * by itself. Call reset() to restart the sequence.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ * @tparam T type of the values
+ */
+template <typename T_COROUTINE, typename T>
+class GeneratorTemplate : public SubCoroutineTemplate<T_COROUTINE> {
+  public:
+    /**
+     * Run the generator until it produces the next value, then copy it into
+     * `value` and return true. Return false if the generator yielded or
+     * delayed without producing a value, or if it is done, which can be
+     * distinguished using isDone().
+     */
+    bool next(T& value) {
+      if (this->isDone()) return false;
+      mValuePtr = &value;
+      mHasValue = false;
+      this->runCoroutine();
+      mValuePtr = nullptr;
+      return mHasValue;
+    }
+
+  protected:
+    /** Constructor. */
+    GeneratorTemplate() = default;
+
+    /**
+     * Used by COROUTINE_YIELD_VALUE(). Not designed to be used directly by
+     * the user.
+     */
+    void setValue(const T& value) {
+      *mValuePtr = value;
+      mHasValue = true;
+    }
+
+  private:
+    /** Destination of the value, valid only during next(). */
+    T* mValuePtr = nullptr;
+
+    /** Set by setValue() during next(). */
+    bool mHasValue = false;
+};
+
+/**
+ * GeneratorTemplate using the default Coroutine class.
+ *
+ * @tparam T type of the values
+ */
+template <typename T>
+using Generator = GeneratorTemplate<Coroutine, T>;
+
+}
+
+#endif
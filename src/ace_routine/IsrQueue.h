@@ -0,0 +1,242 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_ISR_QUEUE_H
+#define ACE_ROUTINE_ISR_QUEUE_H
+
+#include <stdint.h> // uint8_t
+#include "Coroutine.h"
+#include "Event.h"
+
+#if defined(EPOXY_DUINO)
+  #include <atomic>
+#endif
+
+/**
+ * Remove the oldest value of the IsrQueue into `value`, waiting while the
+ * queue is empty. If a value is already available, the coroutine continues
+ * immediately.
+ *
+ * When the coroutine is run by a CoroutineScheduler, it is parked like a
+ * coroutine in COROUTINE_WAIT_EVENT() while the queue is empty, so it consumes
+ * no CPU time until the interrupt service routine pushes a value. When the
+ * coroutine is called directly, the queue is polled on each call.
+ */
+#define COROUTINE_QUEUE_POP(queue, value) \
+    do { \
+      this->setYielding(); \
+      while (!(queue).pop(this, value)) { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+namespace ace_routine {
+
+namespace internal {
+
+#if defined(EPOXY_DUINO)
+
+/**
+ * An index of IsrQueueTemplate written by one side and read by the other.
+ * On a Linux or MacOS host, the producer may be a separate thread, so the
+ * index is a std::atomic, with release-acquire ordering.
+ */
+class IsrQueueIndex {
+  public:
+    uint8_t load() const { return mValue.load(std::memory_order_acquire); }
+
+    void store(uint8_t value) {
+      mValue.store(value, std::memory_order_release);
+    }
+
+  private:
+    std::atomic<uint8_t> mValue{0};
+};
+
+#else
+
+/**
+ * An index of IsrQueueTemplate written by one side and read by the other.
+ * Loads and stores of a single byte are atomic on every microcontroller, so
+ * no lock is needed. The barrier orders the access to the buffer and the
+ * index. On the AVR, which has a single in-order core, only the compiler
+ * must be prevented from reordering. Other processors (e.g. ARM Cortex-M7,
+ * dual core ESP32) need a hardware memory barrier.
+ */
+class IsrQueueIndex {
+  public:
+    uint8_t load() const {
+      uint8_t value = mValue;
+      barrier();
+      return value;
+    }
+
+    void store(uint8_t value) {
+      barrier();
+      mValue = value;
+    }
+
+  private:
+    static void barrier() {
+    #if defined(ARDUINO_ARCH_AVR)
+      __asm__ __volatile__ ("" ::: "memory");
+    #else
+      __sync_synchronize();
+    #endif
+    }
+
+    volatile uint8_t mValue = 0;
+};
+
+#endif
+
+}
+
+/**
+ * A wait-free single-producer, single-consumer queue which passes values from
+ * an interrupt service routine (e.g. UART receive, ADC conversion complete,
+ * pin change) to a coroutine. Unlike Channel and BufferedChannel, its push()
+ * method is safe to call from an ISR. The consumer coroutine uses
+ * COROUTINE_QUEUE_POP().
+ *
+ * The values are held in a ring buffer of `T_SIZE` elements. Each side writes
+ * only its own index (the producer the tail, the consumer the head) with a
+ * single atomic store, after it has accessed the buffer, so neither side ever
+ * waits for the other. When the queue is full, push() drops the value and
+ * returns false, because an ISR cannot wait.
+ *
+ * push() also notifies an internal Event, so a consumer which is parked on
+ * the empty queue is moved back to the ready queue of the CoroutineScheduler.
+ * Like an Event, the queue should be a global or static object which is never
+ * destroyed.
+ *
+ * There must be only one producer (e.g. a single ISR, or several ISRs which
+ * cannot interrupt each other) and one consumer coroutine.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ * @tparam T type of the values
+ * @tparam T_SIZE number of values in the buffer, must be a power of 2, at
+ *    most 128
+ */
+template <typename T_COROUTINE, typename T, uint8_t T_SIZE>
+class IsrQueueTemplate {
+  static_assert(T_SIZE > 0 && T_SIZE <= 128 && (T_SIZE & (T_SIZE - 1)) == 0,
+      "T_SIZE must be a power of 2, at most 128");
+
+  public:
+    /** Constructor. */
+    IsrQueueTemplate() {}
+
+    /** Return the maximum number of values in the queue. */
+    static uint8_t capacity() { return T_SIZE; }
+
+    /**
+     * Return the number of values in the queue. If the other side is
+     * running concurrently, this is only a snapshot.
+     */
+    uint8_t size() const { return (uint8_t) (mTail.load() - mHead.load()); }
+
+    /** Return true if the queue contains no values. */
+    bool isEmpty() const { return size() == 0; }
+
+    /** Return true if the queue is full. */
+    bool isFull() const { return size() == T_SIZE; }
+
+    /**
+     * Append the value and wake up the consumer, or return false if the queue
+     * is full. Safe to call from an interrupt service routine. Must be called
+     * only by the producer.
+     */
+    bool push(const T& value) {
+      uint8_t tail = mTail.load();
+      if ((uint8_t) (tail - mHead.load()) == T_SIZE) return false;
+      mBuffer[tail & kMask] = value;
+      mTail.store(tail + 1);
+      mEvent.notify();
+      return true;
+    }
+
+    /**
+     * Remove the oldest value into `value` and return true, or return false
+     * without waiting if the queue is empty. Must be called only by the
+     * consumer.
+     */
+    bool pop(T& value) {
+      uint8_t head = mHead.load();
+      if (head == mTail.load()) return false;
+      value = mBuffer[head & kMask];
+      mHead.store(head + 1);
+      return true;
+    }
+
+    /**
+     * Used by COROUTINE_QUEUE_POP(). Not designed to be used directly by the
+     * user. Remove the oldest value and return true. Otherwise, park the
+     * coroutine on the internal Event (if it is run by a CoroutineScheduler)
+     * and return false.
+     */
+    bool pop(T_COROUTINE* coroutine, T& value) {
+      // A pending notification may belong to a value which was already
+      // popped, or to a value pushed after the check above, so try again
+      // until the coroutine is actually parked.
+      while (! pop(value)) {
+        if (! mEvent.consume(coroutine)) return false;
+      }
+      return true;
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    IsrQueueTemplate(const IsrQueueTemplate&) = delete;
+    IsrQueueTemplate& operator=(const IsrQueueTemplate&) = delete;
+
+    static const uint8_t kMask = T_SIZE - 1;
+
+    /** Free-running read counter, written only by the consumer. */
+    internal::IsrQueueIndex mHead;
+
+    /** Free-running write counter, written only by the producer. */
+    internal::IsrQueueIndex mTail;
+
+    /** Notified by push() to wake up the parked consumer. */
+    EventTemplate<T_COROUTINE> mEvent;
+
+    T mBuffer[T_SIZE];
+};
+
+/**
+ * IsrQueueTemplate using the default Coroutine class.
+ *
+ * @tparam T type of the values
+ * @tparam T_SIZE number of values in the buffer, must be a power of 2
+ */
+template <typename T, uint8_t T_SIZE>
+using IsrQueue = IsrQueueTemplate<Coroutine, T, T_SIZE>;
+
+}
+
+#endif
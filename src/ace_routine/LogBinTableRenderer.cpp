@@ -129,6 +129,13 @@ void printPStringTo(Print& printer, const char* s, uint8_t boxSize) {
   }
 }
 
+void printUint32To(Print& printer, uint32_t n, uint8_t boxSize) {
+  uint8_t digits = 1;
+  for (uint32_t m = n; m >= 10; m /= 10) digits++;
+  for (uint8_t i = digits; i < boxSize; i++) printer.print(' ');
+  printer.print(n);
+}
+
 void printBinsTo(
     Print& printer,
     const uint16_t bins[],
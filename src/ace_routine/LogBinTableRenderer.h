@@ -56,6 +56,13 @@ void printHeaderTo( Print& printer, uint8_t startBin, uint8_t endBin);
  */
 void printPStringTo(Print& printer, const char* s, uint8_t boxSize);
 
+/**
+ * Print the 32-bit number into boxSize, right justified and padded with
+ * spaces on the left. The ace_common::printPadNTo() helpers handle only 16-bit
+ * numbers. The number is not truncated if it is wider than boxSize.
+ */
+void printUint32To(Print& printer, uint32_t n, uint8_t boxSize);
+
 /**
  * Print the bins of this profiler as a single line of text with each bin
  * printed as a 5-digit number in a 6-character box. If there are any remaining
@@ -0,0 +1,346 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_MPMC_CHANNEL_H
+#define ACE_ROUTINE_MPMC_CHANNEL_H
+
+#include <stdint.h> // uint8_t
+#include "Coroutine.h"
+#include "CoroutineQueue.h"
+
+/**
+ * Write the value to the MpmcChannel, waiting while the buffer is full. The
+ * `value` must survive a yield (e.g. a static or member variable), because it
+ * is read again when the coroutine continues.
+ */
+#define COROUTINE_MPMC_WRITE(channel, value) \
+    do { \
+      this->setYielding(); \
+      while (!(channel).write(this, value)) { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+/**
+ * Read the oldest value of the MpmcChannel into `value`, waiting while the
+ * buffer is empty.
+ */
+#define COROUTINE_MPMC_READ(channel, value) \
+    do { \
+      this->setYielding(); \
+      while (!(channel).read(this, value)) { \
+        COROUTINE_YIELD_INTERNAL(); \
+      } \
+      this->setRunning(); \
+    } while (false)
+
+namespace ace_routine {
+
+/**
+ * A buffered channel which supports multiple writers and multiple readers, for
+ * example a pool of worker coroutines which process the requests written by
+ * several producers. The values are held in a ring buffer of `T_SIZE`
+ * elements. A writer uses COROUTINE_MPMC_WRITE() and a reader uses
+ * COROUTINE_MPMC_READ().
+ *
+ * When a coroutine run by a CoroutineScheduler must wait (a reader on an
+ * empty buffer, or a writer on a full buffer), it is removed from the ready
+ * queue and parked on the FIFO queue of readers or writers of the channel,
+ * like a coroutine waiting for an Event, so that it consumes no CPU time.
+ *
+ * When a value is written while readers are parked, the value is reserved for
+ * the oldest parked reader, which is moved to the ready queue. The channel
+ * records which coroutine holds each reservation, so only that reader can take
+ * the reserved value, and a reader which arrives later cannot take it even if
+ * it runs first. So the readers are served strictly in FIFO order. Likewise, a
+ * slot freed by a read is reserved for the oldest parked writer. There are at
+ * most `T_SIZE` reservations at a time, since a value or a free slot is
+ * reserved for only one coroutine.
+ *
+ * If the holder of a reservation is suspended, terminated or reset() before
+ * it runs, the reservation is released the next time another coroutine finds
+ * the channel empty (or full), and it is passed to the next parked coroutine.
+ * A reset() is detected because it clears the jump point of the holder, which
+ * is recorded with the reservation.
+ *
+ * A coroutine which is called directly (without the CoroutineScheduler) is
+ * not parked, and polls the channel on each call.
+ *
+ * The channel is not safe to use from an interrupt service routine, or from
+ * multiple threads.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ * @tparam T type of the values
+ * @tparam T_SIZE number of values in the buffer, must be a power of 2, at
+ *    most 128
+ */
+template <typename T_COROUTINE, typename T, uint8_t T_SIZE>
+class MpmcChannelTemplate {
+  static_assert(T_SIZE > 0 && T_SIZE <= 128 && (T_SIZE & (T_SIZE - 1)) == 0,
+      "T_SIZE must be a power of 2, at most 128");
+
+  public:
+    /** Constructor. */
+    MpmcChannelTemplate() {}
+
+    /** Return the number of values in the buffer. */
+    uint8_t size() const { return (uint8_t) (mTail - mHead); }
+
+    /** Return true if the buffer contains no values. */
+    bool isEmpty() const { return mTail == mHead; }
+
+    /** Return true if the buffer is full. */
+    bool isFull() const { return size() == T_SIZE; }
+
+    /** Return the number of parked readers. O(N). */
+    uint8_t getNumReaders() const { return mReaders.size(); }
+
+    /** Return the number of parked writers. O(N). */
+    uint8_t getNumWriters() const { return mWriters.size(); }
+
+    /**
+     * Used by COROUTINE_MPMC_WRITE(). Write the value if a slot was reserved
+     * for this coroutine, or if there is a slot which is not reserved for
+     * another writer, and return true. Otherwise, park the coroutine (if it is
+     * run by a CoroutineScheduler) and return false.
+     */
+    bool write(T_COROUTINE* coroutine, const T& value) {
+      if (! releaseWriter(coroutine)) {
+        if (T_SIZE - size() <= mWriteReserved) {
+          releaseStale();
+          if (T_SIZE - size() <= mWriteReserved) {
+            park(mWriters, coroutine);
+            return false;
+          }
+        }
+      }
+      push(value);
+      return true;
+    }
+
+    /**
+     * Used by COROUTINE_MPMC_READ(). Read the oldest value if one was reserved
+     * for this coroutine, or if there is one which is not reserved for another
+     * reader, and return true. Otherwise, park the coroutine (if it is run by
+     * a CoroutineScheduler) and return false.
+     */
+    bool read(T_COROUTINE* coroutine, T& value) {
+      if (! releaseReader(coroutine)) {
+        if (size() <= mReadReserved) {
+          releaseStale();
+          if (size() <= mReadReserved) {
+            park(mReaders, coroutine);
+            return false;
+          }
+        }
+      }
+      pop(value);
+      return true;
+    }
+
+    /**
+     * Read the oldest value which is not reserved for a parked reader, and
+     * return true, or return false without waiting. Used by ChannelSelector.
+     */
+    bool read(T& value) {
+      if (size() > mReadReserved) {
+        pop(value);
+        return true;
+      }
+      return false;
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    MpmcChannelTemplate(const MpmcChannelTemplate&) = delete;
+    MpmcChannelTemplate& operator=(const MpmcChannelTemplate&) = delete;
+
+    using Queue = CoroutineQueueTemplate<T_COROUTINE>;
+
+    static const uint8_t kMask = T_SIZE - 1;
+
+    /** Park the coroutine at the back of the queue, if it has a scheduler. */
+    static void park(Queue& queue, T_COROUTINE* coroutine) {
+      if (coroutine->mScheduler == nullptr) return;
+      coroutine->unlinkFromQueue();
+      queue.pushBack(coroutine);
+    }
+
+    /** Append the value, then hand out the unreserved values to readers. */
+    void push(const T& value) {
+      mBuffer[mTail & kMask] = value;
+      mTail++;
+      reserveReaders();
+    }
+
+    /** Remove the oldest value, then hand out the free slots to writers. */
+    void pop(T& value) {
+      value = mBuffer[mHead & kMask];
+      mHead++;
+      reserveWriters();
+    }
+
+    /**
+     * Reserve the values which are not yet reserved for the oldest parked
+     * readers, and make them ready.
+     */
+    void reserveReaders() {
+      while (size() > mReadReserved && ! mReaders.isEmpty()) {
+        T_COROUTINE* coroutine = mReaders.popFront();
+        mHolders[mReadReserved++].reserve(coroutine);
+        coroutine->makeReady();
+      }
+    }
+
+    /**
+     * Reserve the free slots which are not yet reserved for the oldest parked
+     * writers, and make them ready.
+     */
+    void reserveWriters() {
+      while (T_SIZE - size() > mWriteReserved && ! mWriters.isEmpty()) {
+        T_COROUTINE* coroutine = mWriters.popFront();
+        mHolders[T_SIZE - 1 - mWriteReserved++].reserve(coroutine);
+        coroutine->makeReady();
+      }
+    }
+
+    /**
+     * If the coroutine holds a reserved value, release the reservation, so
+     * that the coroutine can take the value, and return true.
+     */
+    bool releaseReader(T_COROUTINE* coroutine) {
+      for (uint8_t i = 0; i < mReadReserved; i++) {
+        if (mHolders[i].coroutine == coroutine) {
+          mHolders[i] = mHolders[--mReadReserved];
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * If the coroutine holds a reserved slot, release the reservation, so
+     * that the coroutine can fill the slot, and return true.
+     */
+    bool releaseWriter(T_COROUTINE* coroutine) {
+      for (uint8_t i = T_SIZE - mWriteReserved; i < T_SIZE; i++) {
+        if (mHolders[i].coroutine == coroutine) {
+          mHolders[i] = mHolders[T_SIZE - mWriteReserved--];
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * Release the reservations held by coroutines which were suspended,
+     * terminated or reset() before they could use them, and pass them to the
+     * next parked coroutines.
+     */
+    void releaseStale() {
+      for (uint8_t i = 0; i < mReadReserved; ) {
+        if (isStale(mHolders[i])) {
+          mHolders[i] = mHolders[--mReadReserved];
+        } else {
+          i++;
+        }
+      }
+      // The writer moved into a freed entry comes from the front of the
+      // range, so it was already checked.
+      for (uint8_t i = T_SIZE - mWriteReserved; i < T_SIZE; i++) {
+        if (isStale(mHolders[i])) {
+          mHolders[i] = mHolders[T_SIZE - mWriteReserved--];
+        }
+      }
+      reserveReaders();
+      reserveWriters();
+    }
+
+    /**
+     * A coroutine which holds a reservation, and its jump point when the
+     * reservation was made, i.e. the COROUTINE_MPMC_READ() or
+     * COROUTINE_MPMC_WRITE() where it was parked.
+     */
+    struct Holder {
+      void reserve(T_COROUTINE* holder) {
+        coroutine = holder;
+        jump = holder->getJump();
+      }
+
+      T_COROUTINE* coroutine;
+      void* jump;
+    };
+
+    /**
+     * Return true if the holder will not run to use its reservation, because
+     * it was suspended or terminated, or it no longer waits where it was
+     * parked, because it was reset().
+     */
+    static bool isStale(const Holder& holder) {
+      const T_COROUTINE* coroutine = holder.coroutine;
+      return coroutine->isSuspended() || coroutine->isDone()
+          || coroutine->getJump() != holder.jump;
+    }
+
+    /** Free-running read and write counters, see BufferedChannel. */
+    uint8_t mHead = 0;
+    uint8_t mTail = 0;
+
+    /** Number of values reserved for readers which were made ready. */
+    uint8_t mReadReserved = 0;
+
+    /** Number of free slots reserved for writers which were made ready. */
+    uint8_t mWriteReserved = 0;
+
+    /**
+     * The coroutines which hold the reservations. The readers fill the array
+     * from the front, the writers from the back. There are at most T_SIZE
+     * reservations because each one is for a different value or free slot.
+     */
+    Holder mHolders[T_SIZE];
+
+    /** Parked readers, in FIFO order. */
+    Queue mReaders;
+
+    /** Parked writers, in FIFO order. */
+    Queue mWriters;
+
+    T mBuffer[T_SIZE];
+};
+
+/**
+ * MpmcChannelTemplate using the default Coroutine class.
+ *
+ * @tparam T type of the values
+ * @tparam T_SIZE number of values in the buffer, must be a power of 2
+ */
+template <typename T, uint8_t T_SIZE>
+using MpmcChannel = MpmcChannelTemplate<Coroutine, T, T_SIZE>;
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_SCHEDULER_STATS_H
+#define ACE_ROUTINE_SCHEDULER_STATS_H
+
+#include <stdint.h> // uint32_t
+
+/**
+ * Set to 1 to enable the collection of the SchedulerStats by the
+ * CoroutineScheduler, and the run count of each Coroutine. Disabled by
+ * default, so that the code and the counters are removed completely. It must
+ * be defined to the same value in every file which includes AceRoutine.h,
+ * e.g. using a compiler flag, or a `#define` before the `#include`.
+ */
+#ifndef ACE_ROUTINE_SCHEDULER_STATS
+  #define ACE_ROUTINE_SCHEDULER_STATS 0
+#endif
+
+namespace ace_routine {
+
+/**
+ * Counters of the activity of a CoroutineScheduler since the last call to
+ * clear(), available if ACE_ROUTINE_SCHEDULER_STATS is set to 1. In contrast
+ * to the CoroutineProfiler which measures the duration of runCoroutine() of
+ * each coroutine, these measure the scheduler itself:
+ *
+ *  * a pass is one call to CoroutineScheduler::loop(), runPass() or
+ *    loopUntilIdle() (runFor() counts each of its passes), which dispatches
+ *    at most one coroutine for loop(), and every ready coroutine for the
+ *    others
+ *  * a dispatch is one call to runCoroutine()
+ *  * a delay check is a dispatch of a coroutine in COROUTINE_DELAY*() whose
+ *    delay had not expired, so that runCoroutine() did no work
+ *  * an empty pass found no coroutine to run
+ *  * the idle time is the time spent in the idle hook of loopUntilIdle()
+ *
+ * The elapsed time is measured with `micros()`, so the counters should be
+ * cleared more often than every 71 minutes.
+ */
+class SchedulerStats {
+  public:
+    /** Return the time of the last clear(). */
+    uint32_t getStartMicros() const { return mStartMicros; }
+
+    /** Return the number of scheduler passes. */
+    uint32_t getNumPasses() const { return mNumPasses; }
+
+    /** Return the number of passes which found no coroutine to run. */
+    uint32_t getNumEmptyPasses() const { return mNumEmptyPasses; }
+
+    /** Return the number of calls to runCoroutine(). */
+    uint32_t getNumDispatches() const { return mNumDispatches; }
+
+    /** Return the number of dispatches which only checked a delay. */
+    uint32_t getNumDelayChecks() const { return mNumDelayChecks; }
+
+    /** Return the number of microseconds spent in the idle hook. */
+    uint32_t getIdleMicros() const { return mIdleMicros; }
+
+    /** Clear the counters, and restart the elapsed time at `nowMicros`. */
+    void clear(uint32_t nowMicros) {
+      mStartMicros = nowMicros;
+      mNumPasses = 0;
+      mNumEmptyPasses = 0;
+      mNumDispatches = 0;
+      mNumDelayChecks = 0;
+      mIdleMicros = 0;
+    }
+
+    /** Record a pass. Called by the CoroutineScheduler. */
+    void recordPass() { mNumPasses++; }
+
+    /** Record a pass which found nothing to run. */
+    void recordEmptyPass() { mNumEmptyPasses++; }
+
+    /**
+     * Record a call to runCoroutine(). Called by the CoroutineScheduler.
+     *
+     * @param delayCheck true if the coroutine only checked its delay
+     */
+    void recordDispatch(bool delayCheck) {
+      mNumDispatches++;
+      if (delayCheck) mNumDelayChecks++;
+    }
+
+    /** Record the duration of a call to the idle hook. */
+    void recordIdle(uint32_t micros) { mIdleMicros += micros; }
+
+  private:
+    uint32_t mStartMicros = 0;
+    uint32_t mNumPasses = 0;
+    uint32_t mNumEmptyPasses = 0;
+    uint32_t mNumDispatches = 0;
+    uint32_t mNumDelayChecks = 0;
+    uint32_t mIdleMicros = 0;
+};
+
+}
+
+#endif
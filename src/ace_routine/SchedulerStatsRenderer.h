@@ -0,0 +1,134 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_SCHEDULER_STATS_RENDERER_H
+#define ACE_ROUTINE_SCHEDULER_STATS_RENDERER_H
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, UINT32_MAX
+#include <Arduino.h> // Print
+#include "Coroutine.h" // Coroutine
+#include "CoroutineScheduler.h" // CoroutineSchedulerTemplate
+#include "SchedulerStats.h"
+
+namespace ace_routine {
+
+/**
+ * Print the SchedulerStats of the singleton CoroutineScheduler, followed by
+ * the run count of each coroutine, in human-readable tables using the same
+ * 12-character name column and 10-character number columns as the
+ * LogBinTableRenderer. Available only if ACE_ROUTINE_SCHEDULER_STATS is set
+ * to 1. For example:
+ *
+ * @verbatim
+ * elapsed(ms)     passes  passes/s  dispatch checks(%)  empty(%)   idle(%)
+ *         1000    250000    250000    200000        75        20         0
+ * name              runs    runs/s
+ * control           1000      1000
+ * display             10        10
+ * @endverbatim
+ *
+ * The `checks(%)` is the percentage of dispatches which only checked an
+ * unexpired delay. The `empty(%)` is the percentage of passes which found no
+ * coroutine to run. The `idle(%)` is the percentage of the elapsed time spent
+ * in the idle hook of `CoroutineScheduler::loopUntilIdle()`.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class SchedulerStatsRendererTemplate {
+  public:
+    /**
+     * Print the stats of the scheduler, then the run count of each coroutine.
+     *
+     * @param printer destination of output, usually `Serial`
+     * @param clear call CoroutineScheduler::clearStats() after printing
+     *        (default true)
+     */
+    static void printTo(Print& printer, bool clear = true) {
+      using Scheduler = CoroutineSchedulerTemplate<T_COROUTINE>;
+      const SchedulerStats& stats = Scheduler::getStats();
+      uint32_t elapsedMillis =
+          (T_COROUTINE::coroutineMicros() - stats.getStartMicros()) / 1000;
+
+      printer.println(F("elapsed(ms)     passes  passes/s  dispatch"
+          " checks(%)  empty(%)   idle(%)"));
+      printer.print(F("  "));
+      printNumberTo(printer, elapsedMillis);
+      printNumberTo(printer, stats.getNumPasses());
+      printNumberTo(printer, scaledRatio(
+          stats.getNumPasses(), elapsedMillis, 1000));
+      printNumberTo(printer, stats.getNumDispatches());
+      printNumberTo(printer, scaledRatio(
+          stats.getNumDelayChecks(), stats.getNumDispatches(), 100));
+      printNumberTo(printer, scaledRatio(
+          stats.getNumEmptyPasses(), stats.getNumPasses(), 100));
+      printNumberTo(printer, scaledRatio(
+          stats.getIdleMicros() / 1000, elapsedMillis, 100));
+      printer.println();
+
+      printer.println(F("name              runs    runs/s"));
+      T_COROUTINE** root = T_COROUTINE::getRoot();
+      for (T_COROUTINE** p = root; (*p) != nullptr; p = (*p)->getNext()) {
+        (*p)->printNameTo(printer, 12);
+        printNumberTo(printer, (*p)->getRunCount());
+        printNumberTo(printer, scaledRatio(
+            (*p)->getRunCount(), elapsedMillis, 1000));
+        printer.println();
+      }
+
+      if (clear) {
+        Scheduler::clearStats();
+      }
+    }
+
+  private:
+    /**
+     * Return `num * scale / den`, or 0 if `den` is 0. Both numbers are halved
+     * as needed to avoid the overflow of the multiplication, so that the
+     * 64-bit arithmetic is not pulled in on 8-bit processors.
+     */
+    static uint32_t scaledRatio(uint32_t num, uint32_t den, uint16_t scale) {
+      while (num > UINT32_MAX / scale) {
+        num >>= 1;
+        den >>= 1;
+      }
+      return (den == 0) ? 0 : num * scale / den;
+    }
+
+    /** Print the number right justified in a 10-character box. */
+    static void printNumberTo(Print& printer, uint32_t n) {
+      uint8_t digits = 1;
+      for (uint32_t m = n; m >= 10; m /= 10) digits++;
+      for (uint8_t i = digits; i < 10; i++) printer.print(' ');
+      printer.print(n);
+    }
+};
+
+using SchedulerStatsRenderer = SchedulerStatsRendererTemplate<Coroutine>;
+
+} // namespace ace_routine
+
+#endif
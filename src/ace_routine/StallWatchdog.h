@@ -0,0 +1,258 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_STALL_WATCHDOG_H
+#define ACE_ROUTINE_STALL_WATCHDOG_H
+
+#include <stdint.h> // uint8_t, uint32_t
+#include <Arduino.h> // Print
+#include "Coroutine.h"
+
+namespace ace_routine {
+
+/**
+ * Detects the coroutines which run too long without yielding, so that the
+ * other coroutines are stalled. An instance is attached to the scheduler using
+ * `CoroutineScheduler::setStallWatchdog()`. The scheduler then measures each
+ * call to `runCoroutine()` using `Coroutine::coroutineMicros()`, in the same
+ * way as `Coroutine::runCoroutineWithProfiler()`, and passes the duration to
+ * check().
+ *
+ * A call longer than the threshold is recorded in a table of offenders, one
+ * record per coroutine, holding the number of stalls, and the duration of the
+ * last and the worst stall. Then the optional callback is called, for example
+ * to log the name of the coroutine, or to blink an LED. A stall of a coroutine
+ * which does not fit into the table is only counted by getNumDropped().
+ *
+ * This base class contains the logic, and is independent of the size of the
+ * table. The StallWatchdogTemplate subclass provides the storage of the
+ * records.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class StallWatchdogBaseTemplate {
+  public:
+    /**
+     * Function called when a call to runCoroutine() exceeds the threshold,
+     * with the offending coroutine and the duration of the call. It is called
+     * from the scheduler, so it should return quickly.
+     */
+    typedef void (*Callback)(T_COROUTINE* coroutine, uint32_t elapsedMicros);
+
+    /** The stalls of a single coroutine. */
+    struct Record {
+      /** The offending coroutine. Use its printNameTo() for the name. */
+      T_COROUTINE* coroutine;
+
+      /** Number of calls to runCoroutine() which exceeded the threshold. */
+      uint32_t count;
+
+      /** Duration of the most recent stall. */
+      uint32_t lastMicros;
+
+      /** Duration of the longest stall. */
+      uint32_t worstMicros;
+    };
+
+    /** Return the threshold in microseconds. */
+    uint32_t getThresholdMicros() const { return mThresholdMicros; }
+
+    /** Set the threshold in microseconds. */
+    void setThresholdMicros(uint32_t micros) { mThresholdMicros = micros; }
+
+    /** Set the callback. Passing nullptr removes it. */
+    void setCallback(Callback callback) { mCallback = callback; }
+
+    /** Return the number of coroutines which have stalled. */
+    uint8_t getNumRecords() const { return mNumRecords; }
+
+    /** Return the record at index `i`, in the order of the first stall. */
+    const Record& getRecord(uint8_t i) const { return mRecords[i]; }
+
+    /** Return the number of stalls which did not fit into the table. */
+    uint32_t getNumDropped() const { return mNumDropped; }
+
+    /** Remove all the records. */
+    void clear() {
+      mNumRecords = 0;
+      mNumDropped = 0;
+    }
+
+    /**
+     * Check the duration of a call to runCoroutine() of `coroutine` against
+     * the threshold. Called by the CoroutineScheduler. Returns true if the
+     * threshold was exceeded.
+     */
+    bool check(T_COROUTINE* coroutine, uint32_t elapsedMicros) {
+      if (elapsedMicros <= mThresholdMicros) return false;
+
+      Record* record = findRecord(coroutine);
+      if (record != nullptr) {
+        record->count++;
+        record->lastMicros = elapsedMicros;
+        if (elapsedMicros > record->worstMicros) {
+          record->worstMicros = elapsedMicros;
+        }
+      } else {
+        mNumDropped++;
+      }
+
+      if (mCallback) mCallback(coroutine, elapsedMicros);
+      return true;
+    }
+
+    /**
+     * Print the table of offenders to the printer, using the same
+     * 12-character name column as the LogBinTableRenderer. For example:
+     *
+     * @verbatim
+     * name             count  last(us) worst(us)
+     * parser               3     12000     25000
+     * @endverbatim
+     */
+    void printTo(Print& printer) const {
+      printer.println(F("name             count  last(us) worst(us)"));
+      for (uint8_t i = 0; i < mNumRecords; i++) {
+        const Record& record = mRecords[i];
+        record.coroutine->printNameTo(printer, 12);
+        printNumberTo(printer, record.count);
+        printNumberTo(printer, record.lastMicros);
+        printNumberTo(printer, record.worstMicros);
+        printer.println();
+      }
+      if (mNumDropped) {
+        printer.print(F("dropped     "));
+        printNumberTo(printer, mNumDropped);
+        printer.println();
+      }
+    }
+
+  protected:
+    /**
+     * Constructor.
+     *
+     * @param records array of records
+     * @param size size of `records`
+     * @param thresholdMicros longest allowed duration of runCoroutine()
+     * @param callback optional function called on each stall
+     */
+    StallWatchdogBaseTemplate(
+        Record* records,
+        uint8_t size,
+        uint32_t thresholdMicros,
+        Callback callback
+    ) :
+        mRecords(records),
+        mSize(size),
+        mThresholdMicros(thresholdMicros),
+        mCallback(callback)
+    {}
+
+  private:
+    // Disable copy-constructor and assignment operator
+    StallWatchdogBaseTemplate(const StallWatchdogBaseTemplate&) = delete;
+    StallWatchdogBaseTemplate& operator=(const StallWatchdogBaseTemplate&) =
+        delete;
+
+    /**
+     * Return the record of the coroutine, creating it if necessary. Returns
+     * nullptr if the table is full.
+     */
+    Record* findRecord(T_COROUTINE* coroutine) {
+      for (uint8_t i = 0; i < mNumRecords; i++) {
+        if (mRecords[i].coroutine == coroutine) return &mRecords[i];
+      }
+      if (mNumRecords >= mSize) return nullptr;
+
+      Record* record = &mRecords[mNumRecords++];
+      record->coroutine = coroutine;
+      record->count = 0;
+      record->lastMicros = 0;
+      record->worstMicros = 0;
+      return record;
+    }
+
+    /** Print the number right justified in a 10-character box. */
+    static void printNumberTo(Print& printer, uint32_t n) {
+      uint8_t digits = 1;
+      for (uint32_t m = n; m >= 10; m /= 10) digits++;
+      for (uint8_t i = digits; i < 10; i++) printer.print(' ');
+      printer.print(n);
+    }
+
+    Record* const mRecords;
+    uint8_t const mSize;
+    uint8_t mNumRecords = 0;
+    uint32_t mThresholdMicros;
+    uint32_t mNumDropped = 0;
+    Callback mCallback;
+};
+
+/**
+ * A StallWatchdogBaseTemplate with room for `T_SIZE` offending coroutines.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ * @tparam T_SIZE maximum number of offending coroutines which are recorded
+ */
+template <typename T_COROUTINE, uint8_t T_SIZE>
+class StallWatchdogTemplate : public StallWatchdogBaseTemplate<T_COROUTINE> {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param thresholdMicros longest allowed duration of runCoroutine()
+     * @param callback optional function called on each stall
+     */
+    explicit StallWatchdogTemplate(
+        uint32_t thresholdMicros,
+        typename StallWatchdogBaseTemplate<T_COROUTINE>::Callback callback =
+            nullptr
+    ) :
+        StallWatchdogBaseTemplate<T_COROUTINE>(
+            mRecordArray, T_SIZE, thresholdMicros, callback)
+    {}
+
+  private:
+    typename StallWatchdogBaseTemplate<T_COROUTINE>::Record
+        mRecordArray[T_SIZE];
+};
+
+/** StallWatchdogBaseTemplate using the default Coroutine class. */
+using StallWatchdogBase = StallWatchdogBaseTemplate<Coroutine>;
+
+/**
+ * StallWatchdogTemplate using the default Coroutine class.
+ *
+ * @tparam T_SIZE maximum number of offending coroutines which are recorded
+ */
+template <uint8_t T_SIZE>
+using StallWatchdog = StallWatchdogTemplate<Coroutine, T_SIZE>;
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_STATIC_COROUTINE_SCHEDULER_H
+#define ACE_ROUTINE_STATIC_COROUTINE_SCHEDULER_H
+
+#include <stdint.h> // uint8_t
+
+/**
+ * Create the entry of the coroutine `name` for the StaticCoroutineScheduler.
+ * The `name` can be a coroutine defined by COROUTINE(), EXTERN_COROUTINE() or
+ * CRTP_COROUTINE(), or any global instance of a subclass of Coroutine or
+ * CrtpCoroutine.
+ */
+#define STATIC_COROUTINE(name) \
+    ::ace_routine::internal::StaticCoroutineEntry<decltype(name), &name>
+
+namespace ace_routine {
+
+namespace internal {
+
+/**
+ * An entry of the StaticCoroutineScheduler, identifying the global coroutine
+ * instance at compile time. Since the concrete class `T` is known, the calls
+ * to runCoroutine() and setupCoroutine() are qualified with `T::`, which
+ * bypasses the virtual dispatch and allows the compiler to inline them.
+ *
+ * @tparam T concrete subclass of Coroutine or CrtpCoroutine
+ * @tparam T_INSTANCE pointer to the global instance of `T`
+ */
+template <typename T, T* T_INSTANCE>
+struct StaticCoroutineEntry {
+  /** Call the setupCoroutine() method of the coroutine. */
+  static void setupCoroutine() {
+    T_INSTANCE->T::setupCoroutine();
+  }
+
+  /**
+   * Run the coroutine according to its status, using the same rules as the
+   * CoroutineScheduler.
+   */
+  static void runCoroutine() {
+    switch (T_INSTANCE->getStatus()) {
+      case T::kStatusYielding:
+      case T::kStatusDelaying:
+        T_INSTANCE->T::runCoroutine();
+        break;
+
+      case T::kStatusEnding:
+        T_INSTANCE->setTerminated();
+        break;
+
+      default:
+        break;
+    }
+  }
+};
+
+/** Sequence of StaticCoroutineEntry, unrolled by recursion. */
+template <typename... T_ENTRIES>
+struct StaticCoroutineTable;
+
+/** The empty table terminates the recursion. */
+template <>
+struct StaticCoroutineTable<> {
+  static void setupCoroutines() {}
+  static void runCoroutines() {}
+};
+
+/** The first entry followed by the rest of the table. */
+template <typename T_FIRST, typename... T_REST>
+struct StaticCoroutineTable<T_FIRST, T_REST...> {
+  static void setupCoroutines() {
+    T_FIRST::setupCoroutine();
+    StaticCoroutineTable<T_REST...>::setupCoroutines();
+  }
+
+  static void runCoroutines() {
+    T_FIRST::runCoroutine();
+    StaticCoroutineTable<T_REST...>::runCoroutines();
+  }
+};
+
+} // internal
+
+/**
+ * A scheduler whose set of coroutines is fixed at compile time, as an
+ * alternative to the CoroutineScheduler which walks the linked list of
+ * coroutines built at runtime. Each coroutine is identified by its global
+ * instance using the STATIC_COROUTINE() macro:
+ *
+ * @code{.cpp}
+ * COROUTINE(blink) { ... }
+ * COROUTINE(print) { ... }
+ *
+ * using Scheduler = StaticCoroutineScheduler<
+ *     STATIC_COROUTINE(blink),
+ *     STATIC_COROUTINE(print)
+ * >;
+ *
+ * void loop() {
+ *   Scheduler::loop();
+ * }
+ * @endcode
+ *
+ * Each call to loop() runs every coroutine once, in the order of the template
+ * arguments. The sequence of calls is generated at compile time, so there is
+ * no table in RAM, no pointer chasing, and no virtual dispatch: the compiler
+ * can inline each runCoroutine() into loop(). Suspended and Terminated
+ * coroutines are skipped with a single comparison each.
+ *
+ * The coroutines do not support the features which depend on the ready queues
+ * of the CoroutineScheduler (TimerWheel, priorities, Events, deadlines, idle
+ * hooks). A delaying coroutine checks its own delay. The coroutines are still
+ * inserted into the linked list by their constructor, so they must not also be
+ * run by the CoroutineScheduler.
+ *
+ * @tparam T_ENTRIES list of STATIC_COROUTINE() entries
+ */
+template <typename... T_ENTRIES>
+class StaticCoroutineScheduler {
+  public:
+    /** Number of coroutines in the scheduler. */
+    static const uint8_t kNumCoroutines = sizeof...(T_ENTRIES);
+
+    /** Set up the coroutines by calling their setupCoroutine() methods. */
+    static void setupCoroutines() {
+      internal::StaticCoroutineTable<T_ENTRIES...>::setupCoroutines();
+    }
+
+    /** Run each coroutine once, in the order of the template arguments. */
+    static void loop() {
+      internal::StaticCoroutineTable<T_ENTRIES...>::runCoroutines();
+    }
+};
+
+}
+
+#endif
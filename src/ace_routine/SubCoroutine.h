@@ -0,0 +1,66 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef ACE_ROUTINE_SUB_COROUTINE_H
+#define ACE_ROUTINE_SUB_COROUTINE_H
+
+#include "Coroutine.h"
+
+namespace ace_routine {
+
+/**
+ * A coroutine which is called by another coroutine using COROUTINE_CALL(),
+ * for example a reusable multi-step protocol such as an I2C transaction. It
+ * behaves like a normal Coroutine, except that it removes itself from the
+ * singly-linked list of coroutines, so that the CoroutineScheduler does not
+ * run it by itself. Its body should end with COROUTINE_END(), which returns
+ * control to the caller.
+ *
+ * The arguments of the call are usually passed through member variables set
+ * by the caller before COROUTINE_CALL(), and the results are read from member
+ * variables after it.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class SubCoroutineTemplate : public T_COROUTINE {
+  protected:
+    /**
+     * Constructor. The constructor of T_COROUTINE has just inserted this
+     * coroutine at the root of the list, so removing it is O(1).
+     */
+    SubCoroutineTemplate() {
+      *T_COROUTINE::getRoot() = this->mNext;
+      this->mNext = nullptr;
+    }
+};
+
+/** SubCoroutineTemplate using the default Coroutine class. */
+using SubCoroutine = SubCoroutineTemplate<Coroutine>;
+
+}
+
+#endif
@@ -0,0 +1,472 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_THREADED_COROUTINE_SCHEDULER_H
+#define ACE_ROUTINE_THREADED_COROUTINE_SCHEDULER_H
+
+/**
+ * @file ThreadedCoroutineScheduler.h
+ *
+ * A scheduler which runs coroutines on multiple threads of a Linux or MacOS
+ * host. This file is not included by AceRoutine.h because it depends on the
+ * C++ standard thread library, which is not available on microcontrollers. It
+ * must be included explicitly:
+ *
+ * @code
+ * #include <AceRoutine.h>
+ * #include <ace_routine/ThreadedCoroutineScheduler.h>
+ * @endcode
+ */
+
+#if defined(ARDUINO) && ! defined(EPOXY_DUINO)
+  #error ThreadedCoroutineScheduler is supported only on Linux or MacOS hosts
+#endif
+
+#include <stdint.h> // uint8_t, uint32_t
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Coroutine.h"
+
+namespace ace_routine {
+
+/**
+ * A scheduler which distributes its coroutines across N worker threads. Each
+ * worker has its own deque of coroutines. A worker takes the coroutine at the
+ * front of its own deque, runs it, and puts it at the back. When its own deque
+ * is empty, it steals a coroutine from the back of the deque of another
+ * worker.
+ *
+ * A worker which finds no coroutine to run or steal waits on a condition
+ * variable, instead of spinning, until another worker queues a coroutine that
+ * it can steal, the delay of a sleeping coroutine expires, or the scheduler
+ * stops.
+ *
+ * A coroutine which returns through COROUTINE_DELAY() with an unexpired delay
+ * is moved to a shared list of sleeping coroutines, instead of being polled.
+ * A worker moves it back to its own deque when the delay expires, either
+ * between 2 coroutines, or when it wakes up from its wait at the earliest
+ * expiration time.
+ *
+ * A coroutine is always either in exactly one deque or in the sleeping list,
+ * or held by exactly one worker while it runs, so it never runs on two
+ * threads at once. The mutexes of the deques and of the sleeping list provide
+ * the memory ordering between the thread which ran a coroutine previously and
+ * the thread which runs it next.
+ *
+ * The coroutines are moved from the list of the default CoroutineScheduler
+ * using addCoroutine(), like CoroutineScheduler::addCoroutine(). A coroutine
+ * which terminates is removed. A coroutine which is suspended is set aside
+ * until the next start(). Coroutine::suspend(), Coroutine::resume() and
+ * Coroutine::reset() are not thread-safe: they must only be called by the
+ * coroutine itself or while the workers are stopped, never on a coroutine
+ * which another worker may be running.
+ *
+ * The coroutines of one worker thread can run in parallel with those of
+ * another, so any data shared between coroutines (including a Channel) must be
+ * protected by the application.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class ThreadedCoroutineSchedulerTemplate {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param numThreads number of worker threads, at least 1
+     */
+    explicit ThreadedCoroutineSchedulerTemplate(uint8_t numThreads) :
+        mWorkers(numThreads > 0 ? numThreads : 1)
+    {}
+
+    /** Destructor. Stops the worker threads if they are running. */
+    ~ThreadedCoroutineSchedulerTemplate() { stop(); }
+
+    /** Return the number of worker threads. */
+    uint8_t getNumThreads() const { return mWorkers.size(); }
+
+    /**
+     * Move the coroutine from the list of the default CoroutineScheduler to
+     * this scheduler. Must be called while the workers are stopped.
+     */
+    void addCoroutine(T_COROUTINE& coroutine) {
+      for (T_COROUTINE** p = T_COROUTINE::getRoot();
+          (*p) != nullptr;
+          p = (*p)->getNext()) {
+        if (*p == &coroutine) {
+          *p = coroutine.mNext;
+          coroutine.mNext = nullptr;
+          break;
+        }
+      }
+      coroutine.unlinkFromQueue();
+      coroutine.mScheduler = nullptr;
+      mCoroutines.push_back(&coroutine);
+    }
+
+    /**
+     * Distribute the coroutines which are neither terminated nor suspended
+     * among the workers in round-robin order, and start the worker threads.
+     */
+    void start() {
+      if (! mThreads.empty()) return;
+
+      mNumLive = 0;
+      mNumQueued = 0;
+      size_t i = 0;
+      for (T_COROUTINE* coroutine : mCoroutines) {
+        if (coroutine->isTerminated() || coroutine->isSuspended()) continue;
+        mWorkers[i].queue.push_back(coroutine);
+        i = (i + 1) % mWorkers.size();
+        mNumLive++;
+        mNumQueued++;
+      }
+
+      mRunning = true;
+      for (size_t w = 0; w < mWorkers.size(); w++) {
+        mThreads.emplace_back(&ThreadedCoroutineSchedulerTemplate::runWorker,
+            this, w);
+      }
+    }
+
+    /**
+     * Stop the worker threads and wait for them to finish. Each worker
+     * finishes the coroutine that it is currently running first.
+     */
+    void stop() {
+      {
+        std::lock_guard<std::mutex> lock(mIdleMutex);
+        mRunning = false;
+        mIdleCond.notify_all();
+      }
+      for (std::thread& thread : mThreads) {
+        thread.join();
+      }
+      mThreads.clear();
+      for (Worker& worker : mWorkers) {
+        worker.queue.clear();
+      }
+      mSleeping.clear();
+      mNumSleeping = 0;
+    }
+
+    /**
+     * Return the number of coroutines which have neither terminated nor been
+     * suspended since start().
+     */
+    uint32_t getNumLive() const { return mNumLive; }
+
+    /**
+     * Block the calling thread until every coroutine has terminated or been
+     * suspended, then stop the worker threads.
+     */
+    void waitUntilTerminated() {
+      {
+        std::unique_lock<std::mutex> lock(mIdleMutex);
+        mDoneCond.wait(lock, [this] { return mNumLive == 0; });
+      }
+      stop();
+    }
+
+  private:
+    // Disable copy-constructor and assignment operator
+    ThreadedCoroutineSchedulerTemplate(
+        const ThreadedCoroutineSchedulerTemplate&) = delete;
+    ThreadedCoroutineSchedulerTemplate& operator=(
+        const ThreadedCoroutineSchedulerTemplate&) = delete;
+
+    /** The deque of coroutines owned by a worker thread. */
+    struct Worker {
+      std::mutex mutex;
+      std::deque<T_COROUTINE*> queue;
+    };
+
+    /**
+     * Wake-up times further than this are shortened, so that the comparison
+     * of 2 wrapping timestamps remains valid. An early wake-up only recomputes
+     * the wait.
+     */
+    static const uint32_t kMaxSleepMicros = 1000000000;
+
+    /** Main loop of the worker thread at index 'self'. */
+    void runWorker(size_t self) {
+      while (mRunning && mNumLive > 0) {
+        if (mNumSleeping > 0 && isWakeupDue()) {
+          std::lock_guard<std::mutex> lock(mIdleMutex);
+          releaseExpiredLocked(self);
+        }
+
+        T_COROUTINE* coroutine = popLocal(self);
+        if (coroutine == nullptr) coroutine = steal(self);
+        if (coroutine == nullptr) {
+          waitForWork(self);
+          continue;
+        }
+
+        dispatchCoroutine(coroutine);
+        if (coroutine->isTerminated() || coroutine->isSuspended()) {
+          finishCoroutine();
+        } else if (coroutine->isDelaying()
+            && ! coroutine->isDelayTypeExpired()) {
+          sleepCoroutine(coroutine);
+        } else {
+          pushLocal(self, coroutine);
+        }
+      }
+    }
+
+    /**
+     * Put the coroutine at the back of the worker's own deque, and return the
+     * new size of the deque.
+     */
+    size_t enqueue(size_t self, T_COROUTINE* coroutine) {
+      Worker& worker = mWorkers[self];
+      size_t size;
+      {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(coroutine);
+        size = worker.queue.size();
+      }
+      mNumQueued++;
+      return size;
+    }
+
+    /**
+     * Put the coroutine at the back of the worker's own deque. The worker
+     * takes the front coroutine next, so an idle worker is woken up only if
+     * the deque holds another one to steal.
+     */
+    void pushLocal(size_t self, T_COROUTINE* coroutine) {
+      size_t size = enqueue(self, coroutine);
+      if (size > 1 && mNumIdle > 0) {
+        std::lock_guard<std::mutex> lock(mIdleMutex);
+        mIdleCond.notify_one();
+      }
+    }
+
+    /** Take the coroutine at the front of the worker's own deque. */
+    T_COROUTINE* popLocal(size_t self) {
+      Worker& worker = mWorkers[self];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      if (worker.queue.empty()) return nullptr;
+      T_COROUTINE* coroutine = worker.queue.front();
+      worker.queue.pop_front();
+      mNumQueued--;
+      return coroutine;
+    }
+
+    /**
+     * Take the coroutine at the back of the deque of another worker, starting
+     * with the next worker so that the victims are spread out.
+     */
+    T_COROUTINE* steal(size_t self) {
+      size_t numWorkers = mWorkers.size();
+      for (size_t i = 1; i < numWorkers; i++) {
+        Worker& victim = mWorkers[(self + i) % numWorkers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.queue.empty()) continue;
+        T_COROUTINE* coroutine = victim.queue.back();
+        victim.queue.pop_back();
+        mNumQueued--;
+        return coroutine;
+      }
+      return nullptr;
+    }
+
+    /**
+     * Count a coroutine which terminated or was suspended, and wake up
+     * everyone waiting if it was the last one.
+     */
+    void finishCoroutine() {
+      if (--mNumLive > 0) return;
+
+      std::lock_guard<std::mutex> lock(mIdleMutex);
+      mIdleCond.notify_all();
+      mDoneCond.notify_all();
+    }
+
+    /**
+     * Move the coroutine whose delay has not expired to the sleeping list.
+     * If it expires before the other sleeping coroutines, an idle worker is
+     * woken up to shorten its wait.
+     */
+    void sleepCoroutine(T_COROUTINE* coroutine) {
+      uint32_t wakeup = T_COROUTINE::coroutineMicros()
+          + clampSleep(coroutine->getDelayRemainingMicros());
+
+      std::lock_guard<std::mutex> lock(mIdleMutex);
+      mSleeping.push_back(coroutine);
+      mNumSleeping = mSleeping.size();
+      if (mSleeping.size() == 1
+          || (int32_t) (wakeup - mNextWakeupMicros) < 0) {
+        mNextWakeupMicros = wakeup;
+        if (mNumIdle > 0) mIdleCond.notify_one();
+      }
+    }
+
+    /** Return true if the earliest sleeping coroutine may have expired. */
+    bool isWakeupDue() const {
+      return (int32_t) (T_COROUTINE::coroutineMicros() - mNextWakeupMicros)
+          >= 0;
+    }
+
+    static uint32_t clampSleep(uint32_t micros) {
+      return (micros > kMaxSleepMicros) ? kMaxSleepMicros : micros;
+    }
+
+    /**
+     * Move the sleeping coroutines whose delays have expired to the worker's
+     * own deque, and recompute the earliest wake-up time of the others. Must
+     * be called with mIdleMutex locked. Returns true if any coroutine was
+     * moved.
+     */
+    bool releaseExpiredLocked(size_t self) {
+      size_t size = 0;
+      uint32_t nextSleep = kMaxSleepMicros;
+      for (size_t i = 0; i < mSleeping.size(); ) {
+        T_COROUTINE* coroutine = mSleeping[i];
+        if (coroutine->isDelayTypeExpired()) {
+          mSleeping[i] = mSleeping.back();
+          mSleeping.pop_back();
+          size = enqueue(self, coroutine);
+        } else {
+          uint32_t remaining = clampSleep(
+              coroutine->getDelayRemainingMicros());
+          if (remaining < nextSleep) nextSleep = remaining;
+          i++;
+        }
+      }
+
+      mNumSleeping = mSleeping.size();
+      mNextWakeupMicros = T_COROUTINE::coroutineMicros() + nextSleep;
+      if (size > 1 && mNumIdle > 0) mIdleCond.notify_one();
+      return size > 0;
+    }
+
+    /**
+     * Wait until another worker queues a coroutine, the earliest sleeping
+     * coroutine expires, or the scheduler stops. Spurious wake-ups return to
+     * runWorker(), which simply looks for work again.
+     */
+    void waitForWork(size_t self) {
+      std::unique_lock<std::mutex> lock(mIdleMutex);
+      if (releaseExpiredLocked(self)) return;
+
+      // The increment of mNumIdle must precede the check of mNumQueued, and
+      // pushLocal() increments mNumQueued before it checks mNumIdle, so that
+      // at least one of the 2 threads sees the other.
+      mNumIdle++;
+      if (mRunning && mNumLive > 0 && mNumQueued == 0) {
+        if (mSleeping.empty()) {
+          mIdleCond.wait(lock);
+        } else {
+          uint32_t remaining = mNextWakeupMicros
+              - T_COROUTINE::coroutineMicros();
+          if ((int32_t) remaining > 0) {
+            mIdleCond.wait_for(lock, std::chrono::microseconds(remaining));
+          }
+        }
+      }
+      mNumIdle--;
+    }
+
+    /**
+     * Run the coroutine according to its status, in the same way as
+     * CoroutineScheduler.
+     */
+    static void dispatchCoroutine(T_COROUTINE* coroutine) {
+      switch (coroutine->getStatus()) {
+        case T_COROUTINE::kStatusYielding:
+        case T_COROUTINE::kStatusDelaying:
+          coroutine->runActiveFrame();
+          break;
+
+        case T_COROUTINE::kStatusEnding:
+          coroutine->setTerminated();
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    /** Coroutines added using addCoroutine(). */
+    std::vector<T_COROUTINE*> mCoroutines;
+
+    /** One deque per worker thread. */
+    std::vector<Worker> mWorkers;
+
+    /** Worker threads, non-empty between start() and stop(). */
+    std::vector<std::thread> mThreads;
+
+    /**
+     * Coroutines whose delays have not expired, in no particular order.
+     * Guarded by mIdleMutex.
+     */
+    std::vector<T_COROUTINE*> mSleeping;
+
+    /** Guards mSleeping, and the waits on mIdleCond and mDoneCond. */
+    std::mutex mIdleMutex;
+
+    /** Idle workers wait on this. */
+    std::condition_variable mIdleCond;
+
+    /** waitUntilTerminated() waits on this. */
+    std::condition_variable mDoneCond;
+
+    /** Set to false to ask the worker threads to exit. */
+    std::atomic<bool> mRunning{false};
+
+    /** Number of coroutines which have neither terminated nor suspended. */
+    std::atomic<uint32_t> mNumLive{0};
+
+    /** Number of coroutines in the deques of all workers. */
+    std::atomic<uint32_t> mNumQueued{0};
+
+    /** Number of workers waiting on mIdleCond. */
+    std::atomic<uint32_t> mNumIdle{0};
+
+    /** Size of mSleeping, readable without locking mIdleMutex. */
+    std::atomic<uint32_t> mNumSleeping{0};
+
+    /**
+     * The coroutineMicros() at which the earliest sleeping coroutine expires.
+     * Written with mIdleMutex locked.
+     */
+    std::atomic<uint32_t> mNextWakeupMicros{0};
+};
+
+/** ThreadedCoroutineSchedulerTemplate using the default Coroutine class. */
+using ThreadedCoroutineScheduler =
+    ThreadedCoroutineSchedulerTemplate<Coroutine>;
+
+}
+
+#endif
@@ -0,0 +1,240 @@
+/*
+MIT License
+
+Copyright (c) 2022 Brian T. Park
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ACE_ROUTINE_TIMER_WHEEL_H
+#define ACE_ROUTINE_TIMER_WHEEL_H
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, UINT32_MAX
+#include "Coroutine.h"
+#include "CoroutineQueue.h"
+
+namespace ace_routine {
+
+/**
+ * A hashed timing wheel which holds coroutines that are blocked in
+ * COROUTINE_DELAY() or COROUTINE_DELAY_SECONDS(), so that the
+ * CoroutineScheduler does not need to poll them on every iteration. An
+ * instance is attached to the scheduler using
+ * `CoroutineScheduler::setTimerWheel()`.
+ *
+ * The wheel contains `numSlots` queues, each representing 1 millisecond. A
+ * delaying coroutine is placed in the slot indexed by the lower bits of its
+ * wake-up time. Each call to expire() visits only the slots whose millisecond
+ * has elapsed since the previous call, and moves the coroutines whose delay
+ * has actually expired to the given queue. A coroutine whose delay is longer
+ * than `numSlots` milliseconds is simply checked and left in place each time
+ * the wheel goes around, so the cost of a long sleeper is one comparison every
+ * `numSlots` milliseconds, instead of one call to runCoroutine() on every
+ * iteration of the scheduler.
+ *
+ * COROUTINE_DELAY_MICROS() is not handled by the wheel because its resolution
+ * is finer than the 1 millisecond tick. Those coroutines continue to be polled
+ * by the scheduler.
+ *
+ * This base class contains the logic, and is independent of the number of
+ * slots. The TimerWheelTemplate subclass provides the storage of the slots.
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ */
+template <typename T_COROUTINE>
+class TimerWheelBaseTemplate {
+  public:
+    /** Queue of coroutines. */
+    using Queue = CoroutineQueueTemplate<T_COROUTINE>;
+
+    /** Return the number of slots in the wheel. */
+    uint8_t getNumSlots() const { return mNumSlots; }
+
+    /**
+     * Synchronize the current tick of the wheel with the millisecond clock.
+     * Called by the CoroutineScheduler during setup.
+     */
+    void setup() {
+      mCurrentTick = T_COROUTINE::coroutineMillis();
+    }
+
+    /**
+     * Place the delaying coroutine into the slot of its wake-up time. Returns
+     * false if the coroutine is not handled by the wheel (i.e. it is delaying
+     * in units of micros), or its delay has already expired. In those cases,
+     * the coroutine must be placed on the ready queue by the caller.
+     */
+    bool add(T_COROUTINE* coroutine) {
+      // A coroutine in a COROUTINE_CALL() waits for the delay of its child.
+      const T_COROUTINE* frame = coroutine->getDelayFrame();
+      uint16_t wakeTick;
+      switch (frame->mDelayType) {
+        case T_COROUTINE::kDelayTypeMillis:
+        case T_COROUTINE::kDelayTypeEveryMillis:
+          if (frame->isDelayExpired()) return false;
+          wakeTick = frame->mDelayStart + frame->mDelayDuration;
+          break;
+
+        case T_COROUTINE::kDelayTypeSeconds:
+          if (frame->isDelaySecondsExpired()) return false;
+          // Only the lower 16-bits of (seconds * 1000) are needed, which are
+          // preserved even though the seconds were truncated to 16-bits.
+          wakeTick = (uint16_t) (frame->mDelayStart
+              + frame->mDelayDuration) * (uint16_t) 1000;
+          break;
+
+        // A long delay stores the lower 16 bits of its wake-up time in
+        // mDelayStart.
+        case T_COROUTINE::kDelayTypeMillis | T_COROUTINE::kDelayTypeLong:
+          if (frame->isDelayExpired()) return false;
+          wakeTick = frame->mDelayStart;
+          break;
+
+        case T_COROUTINE::kDelayTypeSeconds | T_COROUTINE::kDelayTypeLong:
+          if (frame->isDelaySecondsExpired()) return false;
+          wakeTick = (uint16_t) frame->mDelayStart * (uint16_t) 1000;
+          break;
+
+        default:
+          return false;
+      }
+
+      mSlots[wakeTick & (mNumSlots - 1)].pushBack(coroutine);
+      return true;
+    }
+
+    /**
+     * Visit the slots corresponding to the milliseconds that have elapsed
+     * since the previous call, and move the coroutines whose delay has
+     * expired to the back of `expired`. If more than `numSlots` milliseconds
+     * have passed, every slot is visited exactly once.
+     */
+    void expire(Queue& expired) {
+      uint16_t nowTick = T_COROUTINE::coroutineMillis();
+      uint16_t elapsed = nowTick - mCurrentTick;
+      if (elapsed == 0) return;
+
+      uint16_t tick;
+      if (elapsed >= mNumSlots) {
+        elapsed = mNumSlots;
+        tick = nowTick - mNumSlots;
+      } else {
+        tick = mCurrentTick;
+      }
+      mCurrentTick = nowTick;
+
+      for (; elapsed > 0; elapsed--) {
+        tick++;
+        Queue& slot = mSlots[tick & (mNumSlots - 1)];
+        T_COROUTINE* coroutine = slot.front();
+        while (coroutine != nullptr) {
+          T_COROUTINE* next = slot.next(coroutine);
+          if (coroutine->isDelayTypeExpired()) {
+            coroutine->unlinkFromQueue();
+            expired.pushBack(coroutine);
+          }
+          coroutine = next;
+        }
+      }
+    }
+
+    /**
+     * Return the number of microseconds until the earliest delay of the
+     * coroutines in the wheel expires, or `UINT32_MAX` if the wheel is empty.
+     * This visits every slot and every coroutine in the wheel, so it should be
+     * called only when the scheduler has nothing else to do.
+     */
+    uint32_t getNextWakeupMicros() const {
+      uint32_t next = UINT32_MAX;
+      for (uint8_t i = 0; i < mNumSlots; i++) {
+        const Queue& slot = mSlots[i];
+        for (T_COROUTINE* coroutine = slot.front();
+            coroutine != nullptr;
+            coroutine = slot.next(coroutine)) {
+          uint32_t remaining = coroutine->getDelayRemainingMicros();
+          if (remaining == 0) return 0;
+          if (remaining < next) next = remaining;
+        }
+      }
+      return next;
+    }
+
+  protected:
+    /**
+     * Constructor.
+     *
+     * @param slots array of queues, one for each millisecond
+     * @param numSlots size of `slots`, must be a power of 2
+     */
+    TimerWheelBaseTemplate(Queue* slots, uint8_t numSlots) :
+        mSlots(slots),
+        mNumSlots(numSlots)
+    {}
+
+  private:
+    // Disable copy-constructor and assignment operator
+    TimerWheelBaseTemplate(const TimerWheelBaseTemplate&) = delete;
+    TimerWheelBaseTemplate& operator=(const TimerWheelBaseTemplate&) = delete;
+
+    Queue* const mSlots;
+    uint8_t const mNumSlots;
+
+    /** The most recent millisecond tick processed by expire(). */
+    uint16_t mCurrentTick = 0;
+};
+
+/**
+ * A TimerWheelBaseTemplate with `T_NUM_SLOTS` slots. Each slot consumes 2
+ * pointers of static RAM (4 bytes on AVR, 8 bytes on 32-bit processors).
+ *
+ * @tparam T_COROUTINE class of the specific CoroutineTemplate instantiation,
+ *    usually `Coroutine`
+ * @tparam T_NUM_SLOTS number of 1 millisecond slots, must be a power of 2
+ */
+template <typename T_COROUTINE, uint8_t T_NUM_SLOTS>
+class TimerWheelTemplate : public TimerWheelBaseTemplate<T_COROUTINE> {
+  static_assert(T_NUM_SLOTS > 0 && (T_NUM_SLOTS & (T_NUM_SLOTS - 1)) == 0,
+      "T_NUM_SLOTS must be a power of 2");
+
+  public:
+    /** Constructor. */
+    TimerWheelTemplate() :
+        TimerWheelBaseTemplate<T_COROUTINE>(mSlotArray, T_NUM_SLOTS)
+    {}
+
+  private:
+    typename TimerWheelBaseTemplate<T_COROUTINE>::Queue
+        mSlotArray[T_NUM_SLOTS];
+};
+
+/** TimerWheelBaseTemplate using the default Coroutine class. */
+using TimerWheelBase = TimerWheelBaseTemplate<Coroutine>;
+
+/**
+ * TimerWheelTemplate using the default Coroutine class.
+ *
+ * @tparam T_NUM_SLOTS number of 1 millisecond slots, must be a power of 2
+ */
+template <uint8_t T_NUM_SLOTS>
+using TimerWheel = TimerWheelTemplate<Coroutine, T_NUM_SLOTS>;
+
+}
+
+#endif
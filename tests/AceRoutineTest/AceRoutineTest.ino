@@ -160,6 +160,57 @@ test(AceRoutineTest, macroCoroutine) {
 
 // ---------------------------------------------------------------------------
 
+bool timeoutCoroutineFlag = false;
+bool timeoutCoroutineResult = false;
+uint16_t timeoutCoroutineWakeups = 0;
+
+// A coroutine that waits for the flag, but for at most 10 milliseconds.
+COROUTINE(TestableCoroutine, timeoutCoroutine) {
+  COROUTINE_LOOP() {
+    COROUTINE_AWAIT_TIMEOUT(timeoutCoroutineFlag, 10, timeoutCoroutineResult);
+    timeoutCoroutineWakeups++;
+  }
+}
+
+// Verify COROUTINE_AWAIT_TIMEOUT().
+test(AceRoutineTest, awaitTimeout) {
+  timeoutCoroutineFlag = false;
+  timeoutCoroutineWakeups = 0;
+  TestableClockInterface::setMillis(0);
+  timeoutCoroutine.reset();
+
+  timeoutCoroutine.runCoroutine();
+  assertTrue(timeoutCoroutine.isYielding());
+
+  // Not delaying, so the scheduler polls it on the ready queue.
+  TestableClockInterface::setMillis(9);
+  timeoutCoroutine.runCoroutine();
+  assertTrue(timeoutCoroutine.isYielding());
+  assertEqual(0, timeoutCoroutineWakeups);
+
+  // Timeout fired.
+  TestableClockInterface::setMillis(10);
+  timeoutCoroutine.runCoroutine();
+  assertEqual(1, timeoutCoroutineWakeups);
+  assertFalse(timeoutCoroutineResult);
+  assertTrue(timeoutCoroutine.isYielding());
+
+  // Condition fired before the next timeout, which was restarted at 10.
+  TestableClockInterface::setMillis(15);
+  timeoutCoroutineFlag = true;
+  timeoutCoroutine.runCoroutine();
+  assertEqual(2, timeoutCoroutineWakeups);
+  assertTrue(timeoutCoroutineResult);
+
+  // Condition and timeout on the same poll, the condition wins.
+  TestableClockInterface::setMillis(100);
+  timeoutCoroutine.runCoroutine();
+  assertEqual(3, timeoutCoroutineWakeups);
+  assertTrue(timeoutCoroutineResult);
+}
+
+// ---------------------------------------------------------------------------
+
 test(AceRoutineTest, name_cstring) {
   simpleCoroutine.setName("simple");
   assertEqual(simpleCoroutine.getNameType(), Coroutine::kNameTypeCString);
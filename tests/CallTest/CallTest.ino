@@ -0,0 +1,182 @@
+#line 2 "CallTest.ino"
+
+// Must be defined before any AceRoutine header.
+#define ACE_ROUTINE_DIRECT_CALLS 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Each coroutine counts the number of times that runCoroutine() is called.
+
+class Step : public SubCoroutineTemplate<TestableCoroutine> {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_BEGIN();
+      COROUTINE_DELAY(5);
+      COROUTINE_END();
+    }
+
+    uint16_t calls = 0;
+};
+
+Step step;
+Step periodStep;
+
+class Transaction : public SubCoroutineTemplate<TestableCoroutine> {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_BEGIN();
+      COROUTINE_YIELD();
+      COROUTINE_CALL(step);
+      COROUTINE_CALL(step);
+      COROUTINE_END();
+    }
+
+    uint16_t calls = 0;
+};
+
+Transaction transaction;
+
+class Parent : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_CALL(transaction);
+        transactions++;
+        COROUTINE_DELAY(100);
+      }
+    }
+
+    uint16_t calls = 0;
+    uint16_t transactions = 0;
+};
+
+Parent parent;
+
+// Calls the step at the start of each period. Removed from the scheduler like
+// a SubCoroutine, so that the test runs it directly.
+class Sampler : public SubCoroutineTemplate<TestableCoroutine> {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        samples++;
+        COROUTINE_CALL(periodStep);
+        COROUTINE_EVERY(10);
+      }
+    }
+
+    uint16_t samples = 0;
+};
+
+Sampler sampler;
+
+TimerWheelTemplate<TestableCoroutine, 8> timerWheel;
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+test(CallTest, nestedCalls) {
+  TestableClockInterface::setMillis(0);
+
+  // The transaction yields once, then calls the step, which delays. The
+  // parent takes on the delay of the step, so it goes into the timer wheel.
+  loopTimes(10);
+  assertEqual(1, parent.calls);
+  assertEqual(2, transaction.calls);
+  assertEqual(1, step.calls);
+  assertTrue(parent.isDelaying());
+
+  TestableClockInterface::setMillis(4);
+  loopTimes(10);
+  assertEqual(1, parent.calls);
+  assertEqual(2, transaction.calls);
+  assertEqual(1, step.calls);
+
+  // The step ends, so the scheduler runs the parent, which resumes the
+  // transaction, which calls the step again.
+  TestableClockInterface::setMillis(5);
+  loopTimes(10);
+  assertEqual(2, parent.calls);
+  assertEqual(3, transaction.calls);
+  assertEqual(3, step.calls);
+  assertEqual(0, parent.transactions);
+  assertTrue(parent.isDelaying());
+
+  // The second step ends, which ends the transaction.
+  TestableClockInterface::setMillis(10);
+  loopTimes(10);
+  assertEqual(3, parent.calls);
+  assertEqual(4, transaction.calls);
+  assertEqual(4, step.calls);
+  assertEqual(1, parent.transactions);
+  assertTrue(parent.isDelaying());
+  assertTrue(transaction.isDone());
+}
+
+// Run the coroutine directly at the given millis.
+static void runAt(TestableCoroutine& coroutine, unsigned long millis) {
+  TestableClockInterface::setMillis(millis);
+  coroutine.runCoroutine();
+}
+
+test(CallTest, everyIsKeptAcrossDelayingCall) {
+  runAt(sampler, 0);
+  assertEqual(1, sampler.samples);
+
+  // The caller waits for the delay of its child.
+  assertTrue(sampler.isDelaying());
+  TestableClockInterface::setMillis(4);
+  assertFalse(sampler.isDelayTypeExpired());
+  TestableClockInterface::setMillis(5);
+  assertTrue(sampler.isDelayTypeExpired());
+  runAt(sampler, 5);
+
+  // The period started at 5. The call started at 15 ends at 20, but the
+  // next wakeup stays at 25.
+  runAt(sampler, 15);
+  assertEqual(2, sampler.samples);
+  TestableClockInterface::setMillis(19);
+  assertFalse(sampler.isDelayTypeExpired());
+  runAt(sampler, 20);
+  runAt(sampler, 24);
+  assertEqual(2, sampler.samples);
+  runAt(sampler, 25);
+  assertEqual(3, sampler.samples);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  TestableCoroutineScheduler::setTimerWheel(&timerWheel);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
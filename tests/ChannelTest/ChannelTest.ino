@@ -2,9 +2,13 @@
 
 #include <AceRoutine.h>
 #include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
 
 using namespace ace_routine;
 using namespace aunit;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
 
 Channel<int> channel;
 
@@ -43,6 +47,207 @@ test(ChannelTest, channelWriteMacro) {
 
 // ---------------------------------------------------------------------------
 
+BufferedChannel<int, 4> bufferedChannel;
+
+test(ChannelTest, bufferedReadAndWrite) {
+  int value = 0;
+  assertTrue(bufferedChannel.isEmpty());
+  assertFalse(bufferedChannel.read(value));
+
+  // The writer can write a burst without waiting for the reader.
+  assertTrue(bufferedChannel.write(1));
+  assertTrue(bufferedChannel.write(2));
+  assertTrue(bufferedChannel.write(3));
+  assertTrue(bufferedChannel.write(4));
+  assertTrue(bufferedChannel.isFull());
+  assertFalse(bufferedChannel.write(5));
+  assertEqual(4, bufferedChannel.size());
+
+  // Values are read in FIFO order.
+  assertTrue(bufferedChannel.read(value));
+  assertEqual(1, value);
+  assertTrue(bufferedChannel.read(value));
+  assertEqual(2, value);
+  assertTrue(bufferedChannel.write(5));
+  assertTrue(bufferedChannel.read(value));
+  assertEqual(3, value);
+  assertTrue(bufferedChannel.read(value));
+  assertEqual(4, value);
+  assertTrue(bufferedChannel.read(value));
+  assertEqual(5, value);
+  assertFalse(bufferedChannel.read(value));
+  assertTrue(bufferedChannel.isEmpty());
+}
+
+test(ChannelTest, bufferedRollover) {
+  // The free-running indexes roll over many times.
+  int value = 0;
+  for (int i = 0; i < 1000; i++) {
+    assertTrue(bufferedChannel.write(i));
+    assertTrue(bufferedChannel.write(-i));
+    assertEqual(2, bufferedChannel.size());
+    assertTrue(bufferedChannel.read(value));
+    assertEqual(i, value);
+    assertTrue(bufferedChannel.read(value));
+    assertEqual(-i, value);
+  }
+  assertTrue(bufferedChannel.isEmpty());
+}
+
+test(ChannelTest, bufferedWriteMacro) {
+  int value = 0;
+
+  // Test the methods used by COROUTINE_CHANNEL_WRITE()
+  bufferedChannel.setValue(2);
+  assertTrue(bufferedChannel.write());
+  assertTrue(bufferedChannel.read(value));
+  assertEqual(2, value);
+}
+
+struct Frame {
+  uint32_t sequence;
+  uint8_t data[60];
+};
+
+BufferedChannel<Frame, 2> frameChannel;
+
+test(ChannelTest, reserveCommitPeekRelease) {
+  assertTrue(frameChannel.peek() == nullptr);
+
+  // The slot is not visible to the reader until it is committed.
+  Frame* slot = frameChannel.reserve();
+  assertTrue(slot != nullptr);
+  slot->sequence = 1;
+  assertTrue(frameChannel.peek() == nullptr);
+  frameChannel.commit();
+
+  slot = frameChannel.reserve();
+  slot->sequence = 2;
+  frameChannel.commit();
+  assertTrue(frameChannel.reserve() == nullptr);
+
+  // The reader sees the values in place, in FIFO order.
+  const Frame* frame = frameChannel.peek();
+  assertEqual((uint32_t) 1, frame->sequence);
+  assertTrue(frame == frameChannel.peek());
+  frameChannel.release();
+
+  // The released slot can be reserved again.
+  assertTrue(frameChannel.reserve() != nullptr);
+
+  frame = frameChannel.peek();
+  assertEqual((uint32_t) 2, frame->sequence);
+  frameChannel.release();
+  assertTrue(frameChannel.peek() == nullptr);
+}
+
+// ---------------------------------------------------------------------------
+
+BufferedChannel<int, 4> selectA;
+BufferedChannel<int, 4> selectB;
+Channel<int> selectC;
+int valueA;
+int valueB;
+int valueC;
+ChannelSelector<3> selector;
+
+test(ChannelTest, selectRoundRobin) {
+  assertEqual(-1, selector.select());
+
+  // When several channels are ready, they are selected in turn.
+  for (int i = 0; i < 3; i++) {
+    selectA.write(10 + i);
+    selectB.write(20 + i);
+  }
+  assertEqual(0, selector.select());
+  assertEqual(10, valueA);
+  assertEqual(1, selector.select());
+  assertEqual(20, valueB);
+  assertEqual(0, selector.select());
+  assertEqual(11, valueA);
+  assertEqual(1, selector.select());
+  assertEqual(21, valueB);
+
+  // The unbuffered channel becomes ready after the selector tried to read it.
+  assertFalse(selectC.write(30));
+  assertEqual(2, selector.select());
+  assertEqual(30, valueC);
+  assertTrue(selectC.write(30));
+
+  assertEqual(0, selector.select());
+  assertEqual(12, valueA);
+  assertEqual(1, selector.select());
+  assertEqual(22, valueB);
+  assertEqual(-1, selector.select());
+}
+
+// Counts the values and the timeouts of COROUTINE_SELECT_TIMEOUT().
+class SelectingCoroutine : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_SELECT_TIMEOUT(selector, 100, index);
+        lastIndex = index;
+        if (index < 0) {
+          timeouts++;
+        } else {
+          selected++;
+        }
+      }
+    }
+
+    int8_t index = 0;
+    int8_t lastIndex = 0;
+    uint16_t selected = 0;
+    uint16_t timeouts = 0;
+};
+
+SelectingCoroutine selectingCoroutine;
+
+test(ChannelTest, selectTimeout) {
+  TestableClockInterface::setMillis(0);
+  selectingCoroutine.reset();
+  selectingCoroutine.selected = 0;
+  selectingCoroutine.timeouts = 0;
+  selectingCoroutine.runCoroutine();
+
+  TestableClockInterface::setMillis(50);
+  selectingCoroutine.runCoroutine();
+  assertEqual(0, selectingCoroutine.selected);
+  selectB.write(1);
+  selectingCoroutine.runCoroutine();
+  assertEqual(1, selectingCoroutine.selected);
+  assertEqual(1, selectingCoroutine.lastIndex);
+
+  // The timeout restarts with each select.
+  TestableClockInterface::setMillis(149);
+  selectingCoroutine.runCoroutine();
+  assertEqual(0, selectingCoroutine.timeouts);
+  TestableClockInterface::setMillis(150);
+  selectingCoroutine.runCoroutine();
+  assertEqual(1, selectingCoroutine.timeouts);
+  assertEqual(-1, selectingCoroutine.lastIndex);
+}
+
+test(ChannelTest, selectBeforeYield) {
+  // A channel which already has a value is selected on the first call,
+  // without yielding first.
+  TestableClockInterface::setMillis(0);
+  selectingCoroutine.reset();
+  selectingCoroutine.selected = 0;
+  selectingCoroutine.timeouts = 0;
+  selectB.write(1);
+  selectingCoroutine.runCoroutine();
+  assertEqual(1, selectingCoroutine.selected);
+  assertEqual(1, selectingCoroutine.lastIndex);
+
+  // The next select finds nothing, and yields.
+  assertTrue(selectingCoroutine.isYielding());
+  assertEqual(0, selectingCoroutine.timeouts);
+}
+
+// ---------------------------------------------------------------------------
+
 void setup() {
 #if defined(ARDUINO)
   delay(1000); // some boards reboot twice
@@ -50,6 +255,10 @@ void setup() {
 
   Serial.begin(115200);
   while (!Serial); // Leonardo/Micro
+
+  selector.add(selectA, valueA);
+  selector.add(selectB, valueB);
+  selector.add(selectC, valueC);
 }
 
 void loop() {
@@ -0,0 +1,106 @@
+#line 2 "CoroutinePoolTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Short-lived coroutine which handles one request in 2 steps, then ends.
+class Request : public TestableCoroutine {
+  public:
+    explicit Request(uint16_t id) : id(id) {}
+
+    ~Request() { destroyed++; }
+
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      COROUTINE_YIELD();
+      handled += id;
+      COROUTINE_END();
+    }
+
+    uint16_t const id;
+
+    static uint16_t handled;
+    static uint16_t destroyed;
+};
+
+uint16_t Request::handled = 0;
+uint16_t Request::destroyed = 0;
+
+CoroutinePoolTemplate<TestableCoroutine, Request, 2> pool;
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+test(CoroutinePoolTest, spawnAndReclaim) {
+  assertEqual(2, pool.getCapacity());
+  assertEqual(0, pool.getNumActive());
+
+  Request* r1 = pool.spawn(1);
+  Request* r2 = pool.spawn(2);
+  assertTrue(r1 != nullptr);
+  assertTrue(r2 != nullptr);
+  assertTrue(r1 != r2);
+  assertEqual(2, pool.getNumActive());
+
+  // The pool is full.
+  assertTrue(pool.spawn(3) == nullptr);
+
+  // The spawned coroutines are not added to the linked list of all coroutines.
+  assertTrue(*TestableCoroutine::getRoot() == nullptr);
+
+  // Each request runs twice, then its slot is reclaimed. The destructor is
+  // called only when the slot is reused.
+  loopTimes(4);
+  assertEqual(3, Request::handled);
+  assertEqual(0, pool.getNumActive());
+  assertTrue(r1->isTerminated());
+  assertTrue(r2->isTerminated());
+  assertEqual(0, Request::destroyed);
+
+  // The slots are reused, most recently released first.
+  Request* r3 = pool.spawn(10);
+  assertTrue(r3 == r2);
+  assertEqual(1, Request::destroyed);
+  assertTrue(r3->isYielding());
+  Request* r4 = pool.spawn(20);
+  assertTrue(r4 == r1);
+  assertEqual(2, Request::destroyed);
+  assertTrue(pool.spawn(30) == nullptr);
+
+  loopTimes(4);
+  assertEqual(33, Request::handled);
+  assertEqual(0, pool.getNumActive());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,154 @@
+#line 2 "CrtpCoroutineTest.ino"
+
+#include <AceRoutine.h>
+#include <AceCommon.h> // PrintStr
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_common::PrintStr;
+using ace_routine::testing::TestableClockInterface;
+
+// ---------------------------------------------------------------------------
+
+// Records the order in which the coroutines run.
+PrintStr<16> order;
+
+template <typename T_DERIVED>
+using TestableCrtpCoroutine =
+    CrtpCoroutineTemplate<T_DERIVED, TestableClockInterface, uint16_t>;
+
+class Sleeper : public TestableCrtpCoroutine<Sleeper> {
+  public:
+    int runCoroutine() {
+      order.print('s');
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(100);
+      }
+    }
+
+    void setupCoroutine() {
+      setupCalled = true;
+    }
+
+    bool setupCalled = false;
+};
+
+class Finisher : public TestableCrtpCoroutine<Finisher> {
+  public:
+    int runCoroutine() {
+      order.print('f');
+      COROUTINE_BEGIN();
+      COROUTINE_YIELD();
+      COROUTINE_END();
+    }
+};
+
+// Sleeps longer than the 32767 ms limit of a CrtpCoroutine.
+class LongSleeper : public TestableCrtpCoroutine<LongSleeper> {
+  public:
+    int runCoroutine() {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(70000);
+        wakeups++;
+      }
+    }
+
+    uint16_t wakeups = 0;
+};
+
+Sleeper sleeper;
+Finisher finisher;
+
+using Scheduler = StaticCoroutineScheduler<
+    STATIC_COROUTINE(sleeper),
+    STATIC_COROUTINE(finisher)
+>;
+
+test(CrtpCoroutineTest, noVirtualMethods) {
+  assertLess(sizeof(Sleeper), sizeof(Coroutine));
+}
+
+test(CrtpCoroutineTest, dispatchCoroutine) {
+  Finisher f;
+  order.flush();
+  f.dispatchCoroutine();
+  assertTrue(f.isYielding());
+  f.dispatchCoroutine();
+  assertTrue(f.isEnding());
+  f.dispatchCoroutine();
+  assertTrue(f.isTerminated());
+  f.dispatchCoroutine();
+  assertEqual("ff", order.cstr());
+
+  // Restart from the beginning.
+  f.reset();
+  f.suspend();
+  f.dispatchCoroutine();
+  assertTrue(f.isSuspended());
+  f.resume();
+  f.dispatchCoroutine();
+  assertEqual("fff", order.cstr());
+}
+
+test(CrtpCoroutineTest, longDelayIsClamped) {
+  // The delay is clamped to 32767 ms, instead of being truncated to 16 bits
+  // (70000 % 65536 = 4464 ms).
+  LongSleeper s;
+  TestableClockInterface::setMillis(0);
+  s.dispatchCoroutine();
+  assertTrue(s.isDelaying());
+
+  TestableClockInterface::setMillis(4464);
+  s.dispatchCoroutine();
+  assertEqual(0, s.wakeups);
+
+  TestableClockInterface::setMillis(32766);
+  s.dispatchCoroutine();
+  assertEqual(0, s.wakeups);
+
+  TestableClockInterface::setMillis(32767);
+  s.dispatchCoroutine();
+  assertEqual(1, s.wakeups);
+}
+
+test(CrtpCoroutineTest, staticScheduler) {
+  TestableClockInterface::setMillis(0);
+  Scheduler::setupCoroutines();
+  assertTrue(sleeper.setupCalled);
+
+  order.flush();
+  Scheduler::loop();
+  assertEqual("sf", order.cstr());
+  assertTrue(sleeper.isDelaying());
+
+  // The sleeper is called on each loop() to check its own delay. 'f' ends,
+  // then is terminated and skipped.
+  TestableClockInterface::setMillis(99);
+  Scheduler::loop();
+  Scheduler::loop();
+  Scheduler::loop();
+  assertEqual("sfsfss", order.cstr());
+  assertTrue(finisher.isTerminated());
+
+  TestableClockInterface::setMillis(100);
+  Scheduler::loop();
+  assertEqual("sfsfsss", order.cstr());
+  assertTrue(sleeper.isDelaying());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,189 @@
+#line 2 "DeadlineTest.ino"
+
+// Must be defined before any AceRoutine header.
+#define ACE_ROUTINE_DEADLINES 1
+
+#include <AceRoutine.h>
+#include <AceCommon.h> // PrintStr
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_common::PrintStr;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Records the order in which the coroutines do their work.
+PrintStr<16> order;
+
+// Does 'cost' microseconds of work, then sleeps long enough that it runs only
+// once in each test.
+class Job : public TestableCoroutine {
+  public:
+    Job(char id, uint32_t cost) : id(id), cost(cost) {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        order.print(id);
+        TestableClockInterface::setMicros(
+            TestableClockInterface::micros() + cost);
+        COROUTINE_DELAY_MICROS(10000);
+      }
+    }
+
+    char const id;
+    uint32_t const cost;
+};
+
+// Constructed in reverse order, so the round-robin order is c, b, a.
+Job a('a', 0);
+Job b('b', 100);
+Job c('c', 300);
+
+CoroutineDeadline deadlineA(250);
+CoroutineDeadline deadlineB(150);
+
+// Owned by its own scheduler, so it is not in the list of the singleton.
+Job d('d', 0);
+CoroutineDeadline deadlineD(100);
+CoroutineSchedulerTemplate<TestableCoroutine> otherScheduler;
+
+// Start each test at a new time after all the delays have expired, with
+// cleared counters.
+static void resetState(bool earliestDeadlineFirst) {
+  order.flush();
+  deadlineA.clear();
+  deadlineB.clear();
+  TestableClockInterface::setMicros(TestableClockInterface::micros() + 20000);
+  TestableCoroutineScheduler::setEarliestDeadlineFirst(earliestDeadlineFirst);
+  TestableCoroutineScheduler::setup();
+}
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+test(DeadlineTest, roundRobinCountsMisses) {
+  resetState(false);
+  loopTimes(3);
+  assertEqual("cba", order.cstr());
+
+  // 'b' completes at 400 instead of 150, and 'a' at 400 instead of 250.
+  assertEqual((uint32_t) 1, deadlineB.getRunCount());
+  assertEqual((uint32_t) 1, deadlineB.getMissCount());
+  assertEqual((uint32_t) 250, deadlineB.getWorstLatenessMicros());
+  assertEqual((uint32_t) 1, deadlineA.getRunCount());
+  assertEqual((uint32_t) 1, deadlineA.getMissCount());
+  assertEqual((uint32_t) 150, deadlineA.getWorstLatenessMicros());
+
+  // Polling the delaying coroutines does not count as runs.
+  loopTimes(10);
+  assertEqual("cba", order.cstr());
+  assertEqual((uint32_t) 1, deadlineB.getRunCount());
+  assertEqual((uint32_t) 1, deadlineA.getRunCount());
+}
+
+test(DeadlineTest, earliestDeadlineRunsFirst) {
+  resetState(true);
+  uint32_t start = TestableClockInterface::micros();
+  loopTimes(3);
+  assertEqual("bac", order.cstr());
+
+  assertEqual((uint32_t) 1, deadlineB.getRunCount());
+  assertEqual((uint32_t) 0, deadlineB.getMissCount());
+  assertEqual((uint32_t) 0, deadlineB.getWorstLatenessMicros());
+  assertEqual((uint32_t) 1, deadlineA.getRunCount());
+  assertEqual((uint32_t) 0, deadlineA.getMissCount());
+
+  // The delays of 'a' and 'b' expired at 10100, 100 micros ago. They are
+  // released at that time, not when the scheduler notices the expiration, so
+  // 'b' completes 50 micros after its deadline.
+  TestableClockInterface::setMicros(start + 10200);
+  loopTimes(3);
+  assertEqual("bacba", order.cstr());
+  assertEqual((uint32_t) 1, deadlineB.getMissCount());
+  assertEqual((uint32_t) 50, deadlineB.getWorstLatenessMicros());
+  assertEqual((uint32_t) 0, deadlineA.getMissCount());
+}
+
+test(DeadlineTest, renderer) {
+  resetState(false);
+  loopTimes(3);
+
+  PrintStr<200> output;
+  DeadlineTableRendererTemplate<TestableCoroutine>::printTo(output);
+  assertEqual(
+      "name              runs    misses worst(us)\r\n"
+      "b                    1         1       250\r\n"
+      "a                    1         1       150\r\n",
+      output.cstr());
+
+  // The counters were cleared by printTo().
+  assertEqual((uint32_t) 0, deadlineA.getRunCount());
+  assertEqual((uint32_t) 0, deadlineB.getMissCount());
+}
+
+test(DeadlineTest, rendererOfSchedulerInstance) {
+  resetState(false);
+  otherScheduler.setupScheduler();
+  otherScheduler.runCoroutine();
+
+  PrintStr<200> output;
+  DeadlineTableRendererTemplate<TestableCoroutine>::printTo(
+      output, otherScheduler);
+  assertEqual(
+      "name              runs    misses worst(us)\r\n"
+      "d                    1         0         0\r\n",
+      output.cstr());
+  assertEqual((uint32_t) 0, deadlineD.getRunCount());
+}
+
+test(DeadlineTest, rendererOfArray) {
+  resetState(false);
+  loopTimes(3);
+
+  TestableCoroutine* const coroutines[] = {&c, &a};
+  PrintStr<200> output;
+  DeadlineTableRendererTemplate<TestableCoroutine>::printTo(
+      output, coroutines, 2, false /*clear*/);
+  assertEqual(
+      "name              runs    misses worst(us)\r\n"
+      "a                    1         1       150\r\n",
+      output.cstr());
+  assertEqual((uint32_t) 1, deadlineA.getRunCount());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  a.setName("a");
+  b.setName("b");
+  c.setName("c");
+  a.setDeadline(&deadlineA);
+  b.setDeadline(&deadlineB);
+  d.setName("d");
+  d.setDeadline(&deadlineD);
+  otherScheduler.addCoroutine(d);
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+}
+
+void loop() {
+  TestRunner::run();
+}
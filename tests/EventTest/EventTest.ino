@@ -0,0 +1,177 @@
+#line 2 "EventTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+EventTemplate<TestableCoroutine> event;
+
+// Counts the number of times that runCoroutine() is called, and the number of
+// times that the event was received.
+class Waiter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_WAIT_EVENT(event);
+        received++;
+      }
+    }
+
+    uint16_t calls = 0;
+    uint16_t received = 0;
+};
+
+Waiter waiter1;
+Waiter waiter2;
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+// The order of the tests is not defined, so the tests compare the counters
+// relative to their values at the start of each test.
+
+test(EventTest, waitingCoroutinesAreNotPolled) {
+  // Each waiter runs at most once, which parks it on the event, then it is not
+  // called again.
+  loopTimes(10);
+  uint16_t calls1 = waiter1.calls;
+  uint16_t calls2 = waiter2.calls;
+  loopTimes(10);
+  assertEqual(calls1, waiter1.calls);
+  assertEqual(calls2, waiter2.calls);
+  assertTrue(waiter1.isYielding());
+  assertTrue(waiter2.isYielding());
+  assertEqual((uint32_t) TestableCoroutineScheduler::kNoWakeup,
+      TestableCoroutineScheduler::getNextWakeupMicros());
+
+  // A single notify() wakes up only one waiter, which runs once, then parks
+  // itself at the back of the wait queue.
+  uint16_t received1 = waiter1.received;
+  uint16_t received2 = waiter2.received;
+  event.notify();
+  assertEqual((uint32_t) 0, TestableCoroutineScheduler::getNextWakeupMicros());
+  loopTimes(10);
+  assertEqual(calls1 + calls2 + 1, waiter1.calls + waiter2.calls);
+  assertEqual(received1 + received2 + 1, waiter1.received + waiter2.received);
+  assertFalse(event.isPending());
+
+  // Multiple notify() calls before the scheduler runs are coalesced, and
+  // wake up the other waiter in FIFO order.
+  event.notify();
+  event.notify();
+  loopTimes(10);
+  assertEqual(calls1 + 1, waiter1.calls);
+  assertEqual(received1 + 1, waiter1.received);
+  assertEqual(calls2 + 1, waiter2.calls);
+  assertEqual(received2 + 1, waiter2.received);
+}
+
+test(EventTest, notifyBeforeWait) {
+  // A notify() while the waiters are suspended remains pending.
+  waiter1.suspend();
+  waiter2.suspend();
+  event.notify();
+  loopTimes(10);
+  assertTrue(event.isPending());
+
+  // The resumed coroutine consumes it without blocking, then waits again.
+  uint16_t calls = waiter1.calls;
+  uint16_t received = waiter1.received;
+  waiter1.resume();
+  loopTimes(10);
+  assertEqual(calls + 1, waiter1.calls);
+  assertEqual(received + 1, waiter1.received);
+  assertFalse(event.isPending());
+
+  waiter2.resume();
+  loopTimes(10);
+}
+
+test(EventTest, handOffToWaiter) {
+  // Park both waiters, then take waiter2 out of the wait queue.
+  loopTimes(10);
+  waiter2.suspend();
+  uint16_t received1 = waiter1.received;
+  uint16_t received2 = waiter2.received;
+
+  // The notification is handed to waiter1, so waiter2 cannot steal it by
+  // running first.
+  event.notify();
+  EventTemplate<TestableCoroutine>::drainPending(&event);
+  assertFalse(event.isPending());
+  waiter2.resume();
+  waiter2.runCoroutine();
+  assertEqual(received2, waiter2.received);
+  loopTimes(10);
+  assertEqual(received1 + 1, waiter1.received);
+  assertEqual(received2, waiter2.received);
+
+  // A notification handed to a waiter which is then suspended is taken back
+  // by the next coroutine which waits on the event.
+  waiter1.suspend();
+  event.notify();
+  EventTemplate<TestableCoroutine>::drainPending(&event);
+  waiter2.suspend();
+  waiter1.resume();
+  loopTimes(10);
+  assertEqual(received1 + 2, waiter1.received);
+  waiter2.resume();
+  loopTimes(10);
+  assertEqual(received2, waiter2.received);
+}
+
+test(EventTest, resetReleasesHandOff) {
+  // Park both waiters, then take waiter2 out of the wait queue.
+  loopTimes(10);
+  waiter2.suspend();
+  uint16_t received1 = waiter1.received;
+  uint16_t received2 = waiter2.received;
+
+  // A notification handed to a waiter which is then reset() is taken back,
+  // so another coroutine can consume it.
+  event.notify();
+  EventTemplate<TestableCoroutine>::drainPending(&event);
+  waiter1.reset();
+  waiter2.resume();
+  waiter2.runCoroutine();
+  assertEqual(received2 + 1, waiter2.received);
+  assertFalse(event.isPending());
+
+  // The reset() waiter starts again, and waits for the next notification.
+  loopTimes(10);
+  assertEqual(received1, waiter1.received);
+  assertTrue(waiter1.isYielding());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,89 @@
+#line 2 "GeneratorTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+// ---------------------------------------------------------------------------
+
+// Produces 1, 2, then waits 10 millis, then produces 3 and ends.
+class Counter : public GeneratorTemplate<TestableCoroutine, int> {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_BEGIN();
+      COROUTINE_YIELD_VALUE(1);
+      COROUTINE_YIELD_VALUE(2);
+      COROUTINE_DELAY(10);
+      COROUTINE_YIELD_VALUE(3);
+      COROUTINE_END();
+    }
+
+    uint16_t calls = 0;
+};
+
+Counter counter;
+
+test(GeneratorTest, next) {
+  TestableClockInterface::setMillis(0);
+  counter.reset();
+  counter.calls = 0;
+  int value = 0;
+
+  // Each next() runs the generator once.
+  assertTrue(counter.next(value));
+  assertEqual(1, value);
+  assertTrue(counter.next(value));
+  assertEqual(2, value);
+  assertEqual(2, counter.calls);
+
+  // Delaying produces no value.
+  value = 0;
+  assertFalse(counter.next(value));
+  assertFalse(counter.next(value));
+  assertEqual(0, value);
+  assertTrue(counter.isDelaying());
+
+  TestableClockInterface::setMillis(10);
+  assertTrue(counter.next(value));
+  assertEqual(3, value);
+
+  // End of sequence.
+  assertFalse(counter.next(value));
+  assertTrue(counter.isDone());
+  uint16_t calls = counter.calls;
+  assertFalse(counter.next(value));
+  assertEqual(calls, counter.calls);
+}
+
+test(GeneratorTest, reset) {
+  counter.reset();
+  int value = 0;
+  assertTrue(counter.next(value));
+  assertEqual(1, value);
+
+  counter.reset();
+  assertTrue(counter.next(value));
+  assertEqual(1, value);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
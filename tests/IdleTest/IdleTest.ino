@@ -0,0 +1,176 @@
+#line 2 "IdleTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+class MillisSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(100);
+        calls++;
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+class MicrosSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY_MICROS(500);
+        calls++;
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+class SecondsSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY_SECONDS(3);
+        calls++;
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+MillisSleeper millisSleeper;
+MicrosSleeper microsSleeper;
+SecondsSleeper secondsSleeper;
+
+TimerWheelTemplate<TestableCoroutine, 8> timerWheel;
+
+// The idle hook records its argument, and advances the clock to simulate
+// sleeping for that duration.
+static uint16_t idleCalls;
+static uint32_t idleMicros;
+
+static void idleHook(uint32_t micros) {
+  idleCalls++;
+  idleMicros = micros;
+}
+
+static void setClock(unsigned long millis, unsigned long micros) {
+  TestableClockInterface::setMillis(millis);
+  TestableClockInterface::setMicros(micros);
+  TestableClockInterface::setSeconds(millis / 1000);
+}
+
+// Reset the clock, the coroutines, and the counters before each test.
+static void resetState() {
+  setClock(0, 0);
+  millisSleeper.reset();
+  microsSleeper.reset();
+  secondsSleeper.reset();
+  millisSleeper.calls = 0;
+  microsSleeper.calls = 0;
+  secondsSleeper.calls = 0;
+  idleCalls = 0;
+  idleMicros = 0;
+}
+
+test(IdleTest, nextWakeupPolling) {
+  resetState();
+  TestableCoroutineScheduler::setTimerWheel(nullptr);
+  TestableCoroutineScheduler::setup();
+
+  // Every coroutine is ready before it has run.
+  assertEqual((uint32_t) 0, TestableCoroutineScheduler::getNextWakeupMicros());
+
+  // One pass puts every coroutine into its delay. The earliest wakeup is the
+  // micros sleeper.
+  TestableCoroutineScheduler::loopUntilIdle();
+  assertEqual(1, idleCalls);
+  assertEqual((uint32_t) 500, idleMicros);
+
+  // Advance past the micros delay.
+  setClock(0, 500);
+  assertEqual((uint32_t) 0, TestableCoroutineScheduler::getNextWakeupMicros());
+  TestableCoroutineScheduler::loopUntilIdle();
+  assertEqual(1, microsSleeper.calls);
+  assertEqual(2, idleCalls);
+  assertEqual((uint32_t) 500, idleMicros);
+
+  // Suspend the micros sleeper. The millis sleeper is next. The current
+  // millisecond may be partially elapsed, so the wakeup is rounded down.
+  microsSleeper.suspend();
+  setClock(40, 40000);
+  assertEqual((uint32_t) 59001,
+      TestableCoroutineScheduler::getNextWakeupMicros());
+
+  setClock(100, 100000);
+  TestableCoroutineScheduler::loopUntilIdle();
+  assertEqual(1, millisSleeper.calls);
+  assertEqual(0, secondsSleeper.calls);
+
+  // Suspend everything except the seconds sleeper, which wakes up at 3
+  // seconds. The current second is partially elapsed.
+  millisSleeper.suspend();
+  setClock(1500, 1500000);
+  assertEqual((uint32_t) 1001000,
+      TestableCoroutineScheduler::getNextWakeupMicros());
+
+  // Nothing will wake up with the passage of time.
+  secondsSleeper.suspend();
+  assertEqual(TestableCoroutineScheduler::kNoWakeup,
+      TestableCoroutineScheduler::getNextWakeupMicros());
+
+  microsSleeper.resume();
+  millisSleeper.resume();
+  secondsSleeper.resume();
+}
+
+test(IdleTest, nextWakeupWithTimerWheel) {
+  resetState();
+  TestableCoroutineScheduler::setTimerWheel(&timerWheel);
+  TestableCoroutineScheduler::setup();
+
+  // The millis and seconds sleepers go into the wheel, but are still taken
+  // into account.
+  microsSleeper.suspend();
+  TestableCoroutineScheduler::loopUntilIdle();
+  assertEqual(1, idleCalls);
+  assertEqual((uint32_t) 99001, idleMicros);
+
+  setClock(100, 100000);
+  assertEqual((uint32_t) 0, TestableCoroutineScheduler::getNextWakeupMicros());
+  TestableCoroutineScheduler::loopUntilIdle();
+  assertEqual(1, millisSleeper.calls);
+  assertEqual(2, idleCalls);
+  assertEqual((uint32_t) 99001, idleMicros);
+
+  microsSleeper.resume();
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableCoroutineScheduler::setIdleHook(idleHook);
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,156 @@
+#line 2 "IsrQueueTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+#if defined(EPOXY_DUINO)
+  #include <thread>
+#endif
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Written by the test, which plays the role of the interrupt service routine.
+IsrQueueTemplate<TestableCoroutine, int, 4> queue;
+
+// Counts the number of times that runCoroutine() is called, and keeps the sum
+// of the values that it received.
+class Consumer : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_QUEUE_POP(queue, value);
+        received++;
+        sum += value;
+      }
+    }
+
+    int value = 0;
+    int sum = 0;
+    uint16_t calls = 0;
+    uint16_t received = 0;
+};
+
+Consumer consumer;
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+// The order of the tests is not defined, so the tests compare the counters
+// relative to their values at the start of each test.
+
+test(IsrQueueTest, consumerIsNotPolled) {
+  // The consumer runs once, which parks it on the empty queue.
+  loopTimes(10);
+  uint16_t calls = consumer.calls;
+  loopTimes(10);
+  assertEqual(calls, consumer.calls);
+  assertTrue(consumer.isYielding());
+
+  // A push wakes it up, and it runs once for each value that it pops.
+  uint16_t received = consumer.received;
+  int sum = consumer.sum;
+  assertTrue(queue.push(3));
+  loopTimes(10);
+  assertEqual(calls + 1, consumer.calls);
+  assertEqual(received + 1, consumer.received);
+  assertEqual(sum + 3, consumer.sum);
+
+  // Several pushes before the scheduler runs are all delivered in one call.
+  assertTrue(queue.push(4));
+  assertTrue(queue.push(5));
+  loopTimes(10);
+  assertEqual(calls + 2, consumer.calls);
+  assertEqual(received + 3, consumer.received);
+  assertEqual(sum + 3 + 4 + 5, consumer.sum);
+  assertTrue(queue.isEmpty());
+}
+
+test(IsrQueueTest, pushToFullQueue) {
+  loopTimes(10);
+  consumer.suspend();
+
+  // A full queue drops the value.
+  for (int i = 0; i < 4; i++) {
+    assertTrue(queue.push(i));
+  }
+  assertTrue(queue.isFull());
+  assertFalse(queue.push(100));
+
+  // The free-running indexes roll over correctly.
+  int value;
+  for (int i = 0; i < 300; i++) {
+    assertTrue(queue.pop(value));
+    assertEqual(i, value);
+    assertTrue(queue.push(i + 4));
+  }
+  assertEqual(4, queue.size());
+
+  uint16_t received = consumer.received;
+  consumer.resume();
+  loopTimes(10);
+  assertEqual(received + 4, consumer.received);
+  assertTrue(queue.isEmpty());
+}
+
+#if defined(EPOXY_DUINO)
+
+IsrQueueTemplate<TestableCoroutine, uint16_t, 8> threadQueue;
+
+// On a Linux or MacOS host, the producer can be a real thread. The queue is
+// smaller than the count, so the producer must wait for the consumer.
+test(IsrQueueTest, producerThread) {
+  const uint16_t kCount = 100;
+  std::thread producer([]() {
+    for (uint16_t i = 0; i < kCount; i++) {
+      while (! threadQueue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint16_t expected = 0;
+  uint16_t value;
+  while (expected < kCount) {
+    if (threadQueue.pop(value)) {
+      if (value != expected) break;
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  assertEqual(kCount, expected);
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
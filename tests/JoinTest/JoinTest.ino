@@ -0,0 +1,105 @@
+#line 2 "JoinTest.ino"
+
+// Must be defined before any AceRoutine header.
+#define ACE_ROUTINE_JOIN_PARKING 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+COROUTINE(TestableCoroutine, slowChild) {
+  COROUTINE_BEGIN();
+  COROUTINE_DELAY(10);
+  COROUTINE_END();
+}
+
+COROUTINE(TestableCoroutine, fastChild) {
+  COROUTINE_BEGIN();
+  COROUTINE_DELAY(5);
+  COROUTINE_END();
+}
+
+// Joins both children, counting the number of times that runCoroutine() is
+// called.
+class Parent : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_BEGIN();
+      COROUTINE_JOIN(slowChild);
+      // Already done, so this does not yield.
+      COROUTINE_JOIN(fastChild);
+      COROUTINE_END();
+    }
+
+    uint16_t calls = 0;
+};
+
+Parent parent;
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+test(JoinTest, joinIsNotPolled) {
+  // The parent runs once, then parks itself until a coroutine ends.
+  loopTimes(10);
+  assertEqual(1, parent.calls);
+  assertTrue(parent.isYielding());
+
+  // Just before the fast child ends.
+  TestableClockInterface::setMillis(4);
+  loopTimes(10);
+  assertEqual(1, parent.calls);
+
+  // The fast child ends, which does not wake up the parent, because it is
+  // joining the slow child.
+  TestableClockInterface::setMillis(5);
+  loopTimes(10);
+  assertTrue(fastChild.isDone());
+  assertEqual(1, parent.calls);
+  assertTrue(parent.isYielding());
+
+  TestableClockInterface::setMillis(9);
+  loopTimes(10);
+  assertEqual(1, parent.calls);
+
+  // The slow child ends, which wakes up the parent, and the join of the fast
+  // child continues immediately.
+  TestableClockInterface::setMillis(10);
+  loopTimes(10);
+  assertTrue(slowChild.isDone());
+  assertEqual(2, parent.calls);
+  assertTrue(parent.isDone());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,167 @@
+#line 2 "LongDelayTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+// ---------------------------------------------------------------------------
+
+// Each coroutine counts the number of times that it wakes up from its delay.
+
+class MillisSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(100000);
+        wakeups++;
+      }
+    }
+
+    uint16_t wakeups = 0;
+};
+
+class MicrosSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY_MICROS(100000);
+        wakeups++;
+      }
+    }
+
+    uint16_t wakeups = 0;
+};
+
+class SecondsSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY_SECONDS(40000);
+        wakeups++;
+      }
+    }
+
+    uint16_t wakeups = 0;
+};
+
+MillisSleeper millisSleeper;
+MicrosSleeper microsSleeper;
+SecondsSleeper secondsSleeper;
+
+test(LongDelayTest, delayMillis) {
+  TestableClockInterface::setMillis(0);
+  millisSleeper.reset();
+  millisSleeper.wakeups = 0;
+  millisSleeper.runCoroutine();
+  assertTrue(millisSleeper.isDelaying());
+  assertEqual((uint32_t) 99999001, millisSleeper.getDelayRemainingMicros());
+
+  // A 16-bit delay would have expired long before this.
+  TestableClockInterface::setMillis(99999);
+  millisSleeper.runCoroutine();
+  assertEqual(0, millisSleeper.wakeups);
+  assertEqual((uint32_t) 1, millisSleeper.getDelayRemainingMicros());
+
+  TestableClockInterface::setMillis(100000);
+  assertEqual((uint32_t) 0, millisSleeper.getDelayRemainingMicros());
+  millisSleeper.runCoroutine();
+  assertEqual(1, millisSleeper.wakeups);
+}
+
+test(LongDelayTest, delayMillisAcrossRollover) {
+  TestableClockInterface::setMillis(UINT32_MAX - 50000);
+  millisSleeper.reset();
+  millisSleeper.wakeups = 0;
+  millisSleeper.runCoroutine();
+
+  TestableClockInterface::setMillis(UINT32_MAX);
+  millisSleeper.runCoroutine();
+  assertEqual(0, millisSleeper.wakeups);
+
+  TestableClockInterface::setMillis(49998);
+  millisSleeper.runCoroutine();
+  assertEqual(0, millisSleeper.wakeups);
+
+  TestableClockInterface::setMillis(49999);
+  millisSleeper.runCoroutine();
+  assertEqual(1, millisSleeper.wakeups);
+}
+
+test(LongDelayTest, delayMicros) {
+  TestableClockInterface::setMicros(1000);
+  microsSleeper.reset();
+  microsSleeper.wakeups = 0;
+  microsSleeper.runCoroutine();
+  assertEqual((uint32_t) 100000, microsSleeper.getDelayRemainingMicros());
+
+  TestableClockInterface::setMicros(100999);
+  microsSleeper.runCoroutine();
+  assertEqual(0, microsSleeper.wakeups);
+
+  TestableClockInterface::setMicros(101000);
+  microsSleeper.runCoroutine();
+  assertEqual(1, microsSleeper.wakeups);
+}
+
+test(LongDelayTest, delaySeconds) {
+  TestableClockInterface::setSeconds(10);
+  secondsSleeper.reset();
+  secondsSleeper.wakeups = 0;
+  secondsSleeper.runCoroutine();
+
+  TestableClockInterface::setSeconds(40009);
+  secondsSleeper.runCoroutine();
+  assertEqual(0, secondsSleeper.wakeups);
+
+  TestableClockInterface::setSeconds(40010);
+  secondsSleeper.runCoroutine();
+  assertEqual(1, secondsSleeper.wakeups);
+}
+
+test(LongDelayTest, timerWheel) {
+  TimerWheelTemplate<TestableCoroutine, 8> wheel;
+  CoroutineQueueTemplate<TestableCoroutine> expired;
+
+  TestableClockInterface::setMillis(1000);
+  wheel.setup();
+  millisSleeper.reset();
+  millisSleeper.wakeups = 0;
+  millisSleeper.runCoroutine();
+  assertTrue(wheel.add(&millisSleeper));
+
+  // Going around the wheel does not expire the long delay.
+  for (uint32_t t = 1001; t < 101000; t += 7) {
+    TestableClockInterface::setMillis(t);
+    wheel.expire(expired);
+  }
+  TestableClockInterface::setMillis(100999);
+  wheel.expire(expired);
+  assertTrue(expired.isEmpty());
+
+  TestableClockInterface::setMillis(101000);
+  wheel.expire(expired);
+  assertEqual(&millisSleeper, expired.popFront());
+  millisSleeper.runCoroutine();
+  assertEqual(1, millisSleeper.wakeups);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,296 @@
+#line 2 "MpmcChannelTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+MpmcChannelTemplate<TestableCoroutine, int, 2> channel;
+
+class Worker;
+
+// The worker which received the most recent value.
+Worker* lastWorker = nullptr;
+
+// Sum of all values received by the workers.
+int receivedSum = 0;
+
+// Counts the number of times that runCoroutine() is called, and the number of
+// values that it received.
+class Worker : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_MPMC_READ(channel, value);
+        received++;
+        receivedSum += value;
+        lastWorker = this;
+      }
+    }
+
+    int value = 0;
+    uint16_t calls = 0;
+    uint16_t received = 0;
+};
+
+// Writes 'remaining' consecutive values, starting at 'next'.
+class Producer : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT(remaining > 0);
+        calls++;
+        COROUTINE_MPMC_WRITE(channel, next);
+        next++;
+        remaining--;
+      }
+    }
+
+    int next = 0;
+    uint16_t calls = 0;
+    uint16_t remaining = 0;
+};
+
+Worker worker1;
+Worker worker2;
+Worker worker3;
+Producer producer1;
+Producer producer2;
+
+MpmcChannelTemplate<TestableCoroutine, int, 1> single;
+
+// Reads the 'single' channel, and remembers the sum of the values.
+class SingleReader : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_MPMC_READ(single, value);
+        received++;
+        sum += value;
+      }
+    }
+
+    int value = 0;
+    int sum = 0;
+    uint16_t received = 0;
+};
+
+// Writes 'remaining' consecutive values to the 'single' channel.
+class SingleWriter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_AWAIT(remaining > 0);
+        COROUTINE_MPMC_WRITE(single, next);
+        next++;
+        remaining--;
+      }
+    }
+
+    int next = 0;
+    uint16_t remaining = 0;
+};
+
+SingleReader singleReader1;
+SingleReader singleReader2;
+SingleWriter singleWriter;
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+static uint16_t totalCalls() {
+  return worker1.calls + worker2.calls + worker3.calls;
+}
+
+// The order of the tests is not defined, so the tests compare the counters
+// relative to their values at the start of each test.
+
+test(MpmcChannelTest, readersAreServedInFifoOrder) {
+  // Each worker runs at most once, which parks it on the channel, then it is
+  // not called again.
+  loopTimes(10);
+  uint16_t calls = totalCalls();
+  loopTimes(10);
+  assertEqual(calls, totalCalls());
+  assertEqual(3, channel.getNumReaders());
+
+  // Each value goes to the oldest parked worker, which runs once, then parks
+  // itself at the back of the queue. So the workers take turns.
+  Worker* receivers[6];
+  int sum = receivedSum;
+  for (uint8_t i = 0; i < 6; i++) {
+    producer1.next = i;
+    producer1.remaining = 1;
+    loopTimes(10);
+    receivers[i] = lastWorker;
+    assertEqual(calls + i + 1, totalCalls());
+    assertTrue(channel.isEmpty());
+  }
+  assertTrue(receivers[0] != receivers[1]);
+  assertTrue(receivers[1] != receivers[2]);
+  assertTrue(receivers[2] != receivers[0]);
+  assertTrue(receivers[0] == receivers[3]);
+  assertTrue(receivers[1] == receivers[4]);
+  assertTrue(receivers[2] == receivers[5]);
+  assertEqual(sum + 0 + 1 + 2 + 3 + 4 + 5, receivedSum);
+  assertEqual(3, channel.getNumReaders());
+}
+
+test(MpmcChannelTest, writersParkWhenFull) {
+  loopTimes(10);
+  worker1.suspend();
+  worker2.suspend();
+  worker3.suspend();
+  assertEqual(0, channel.getNumReaders());
+
+  // Both producers fill the buffer, then park, and are not polled anymore.
+  producer1.next = 100;
+  producer1.remaining = 3;
+  producer2.next = 200;
+  producer2.remaining = 3;
+  loopTimes(10);
+  assertTrue(channel.isFull());
+  assertEqual(2, channel.getNumWriters());
+  uint16_t calls1 = producer1.calls;
+  uint16_t calls2 = producer2.calls;
+  loopTimes(10);
+  assertEqual(calls1, producer1.calls);
+  assertEqual(calls2, producer2.calls);
+
+  // A single worker drains both producers. Each slot freed by a read is
+  // handed to the oldest parked producer.
+  uint16_t received = worker1.received;
+  int sum = receivedSum;
+  worker1.resume();
+  loopTimes(30);
+  assertEqual(received + 6, worker1.received);
+  assertEqual(sum + 100 + 101 + 102 + 200 + 201 + 202, receivedSum);
+  assertEqual(0, producer1.remaining);
+  assertEqual(0, producer2.remaining);
+  assertTrue(channel.isEmpty());
+  assertEqual(0, channel.getNumWriters());
+
+  worker2.resume();
+  worker3.resume();
+  loopTimes(10);
+  assertEqual(3, channel.getNumReaders());
+}
+
+test(MpmcChannelTest, reservationIsNotStolen) {
+  // Park only singleReader1, then write a value, which is reserved for it.
+  singleReader2.suspend();
+  loopTimes(10);
+  uint16_t received1 = singleReader1.received;
+  uint16_t received2 = singleReader2.received;
+  singleWriter.next = 10;
+  singleWriter.remaining = 1;
+  singleWriter.runCoroutine();
+  assertEqual(1, single.size());
+
+  // singleReader2 runs first, but cannot take the value, so it parks.
+  singleReader2.resume();
+  singleReader2.runCoroutine();
+  assertEqual(received2, singleReader2.received);
+  assertEqual(1, single.getNumReaders());
+  loopTimes(10);
+  assertEqual(received1 + 1, singleReader1.received);
+  assertEqual(received2, singleReader2.received);
+  assertTrue(single.isEmpty());
+}
+
+test(MpmcChannelTest, reservationOfSuspendedReaderIsReleased) {
+  // Park singleReader1 in front of singleReader2.
+  singleReader2.suspend();
+  loopTimes(10);
+  singleReader2.resume();
+  loopTimes(10);
+  assertEqual(2, single.getNumReaders());
+  uint16_t received1 = singleReader1.received;
+  uint16_t received2 = singleReader2.received;
+  int sum2 = singleReader2.sum;
+
+  // The value is reserved for singleReader1, which is suspended before it
+  // runs.
+  singleWriter.next = 20;
+  singleWriter.remaining = 1;
+  singleWriter.runCoroutine();
+  singleReader1.suspend();
+
+  // The reservation is released when the writer finds the buffer full, and
+  // passed to singleReader2. Otherwise, the buffer of size 1 would stay full
+  // forever.
+  singleWriter.remaining = 1;
+  loopTimes(20);
+  assertEqual(0, singleWriter.remaining);
+  assertEqual(received1, singleReader1.received);
+  assertEqual(received2 + 2, singleReader2.received);
+  assertEqual(sum2 + 20 + 21, singleReader2.sum);
+
+  singleReader1.resume();
+  loopTimes(10);
+  assertTrue(single.isEmpty());
+  assertEqual(2, single.getNumReaders());
+}
+
+test(MpmcChannelTest, reservationOfResetReaderIsReleased) {
+  // Park singleReader1 in front of singleReader2.
+  singleReader2.suspend();
+  loopTimes(10);
+  singleReader2.resume();
+  loopTimes(10);
+  assertEqual(2, single.getNumReaders());
+  uint16_t received1 = singleReader1.received;
+  uint16_t received2 = singleReader2.received;
+  int sum2 = singleReader2.sum;
+
+  // The value is reserved for singleReader1, which is reset() before it runs.
+  singleWriter.next = 30;
+  singleWriter.remaining = 1;
+  singleWriter.runCoroutine();
+  singleReader1.reset();
+
+  // The reservation is released when the writer finds the buffer full, and
+  // passed to singleReader2. The reset() reader starts again, and receives
+  // the next value.
+  singleWriter.remaining = 1;
+  singleWriter.runCoroutine();
+  loopTimes(20);
+  assertEqual(0, singleWriter.remaining);
+  assertEqual(received2 + 1, singleReader2.received);
+  assertEqual(sum2 + 30, singleReader2.sum);
+  assertEqual(received1 + 1, singleReader1.received);
+  assertTrue(single.isEmpty());
+  assertEqual(2, single.getNumReaders());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
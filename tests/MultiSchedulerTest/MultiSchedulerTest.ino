@@ -0,0 +1,311 @@
+#line 2 "MultiSchedulerTest.ino"
+
+// Must be defined before any AceRoutine header.
+#define ACE_ROUTINE_JOIN_PARKING 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include <AceCommon.h> // PrintStr
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+using ace_common::PrintStr;
+
+// ---------------------------------------------------------------------------
+
+// Each coroutine counts the number of times that it resumed.
+class Counter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        calls++;
+        COROUTINE_YIELD();
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+Counter fast1;
+Counter fast2;
+Counter slow;
+Counter global;
+
+// Ends when 'childMayEnd' is set.
+bool childMayEnd = false;
+
+COROUTINE(TestableCoroutine, child) {
+  COROUTINE_BEGIN();
+  COROUTINE_AWAIT(childMayEnd);
+  COROUTINE_END();
+}
+
+// Joins the child run by another scheduler, counting the number of times that
+// runCoroutine() is called.
+class Joiner : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_BEGIN();
+      COROUTINE_JOIN(child);
+      COROUTINE_END();
+    }
+
+    uint16_t calls = 0;
+};
+
+Joiner joiner;
+
+EventTemplate<TestableCoroutine> event;
+
+// Counts the number of times that the event was received.
+class EventWaiter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_WAIT_EVENT(event);
+        received++;
+      }
+    }
+
+    uint16_t received = 0;
+};
+
+EventWaiter eventWaiter;
+
+TestableCoroutineScheduler fastScheduler;
+TestableCoroutineScheduler slowScheduler;
+TestableCoroutineScheduler joinScheduler;
+TestableCoroutineScheduler eventScheduler;
+TestableCoroutineScheduler emptyScheduler;
+
+test(MultiSchedulerTest, addCoroutine) {
+  // Only 'global' remains in the list of the singleton scheduler.
+  PrintStr<100> output;
+  TestableCoroutineScheduler::list(output);
+  PrintStr<100> expected;
+  printfTo(expected, "Coroutine 0x%lX; status: Yielding\r\n",
+      (unsigned long) &global);
+  assertEqual(expected.cstr(), output.cstr());
+
+  // The coroutines of the other instances are listed in the order added.
+  output.flush();
+  fastScheduler.listCoroutines(output);
+  expected.flush();
+  printfTo(expected, "Coroutine 0x%lX; status: Yielding\r\n",
+      (unsigned long) &fast1);
+  printfTo(expected, "Coroutine 0x%lX; status: Yielding\r\n",
+      (unsigned long) &fast2);
+  assertEqual(expected.cstr(), output.cstr());
+}
+
+test(MultiSchedulerTest, independentSchedulers) {
+  // Each scheduler runs only its own coroutines.
+  fastScheduler.runCoroutinePass();
+  assertEqual(1, fast1.calls);
+  assertEqual(1, fast2.calls);
+  assertEqual(0, slow.calls);
+  assertEqual(0, global.calls);
+
+  fastScheduler.runCoroutinePass();
+  slowScheduler.runCoroutinePass();
+  assertEqual(2, fast1.calls);
+  assertEqual(2, fast2.calls);
+  assertEqual(1, slow.calls);
+  assertEqual(0, global.calls);
+
+  TestableCoroutineScheduler::loop();
+  assertEqual(1, global.calls);
+  assertEqual(1, slow.calls);
+
+  // Suspend and resume put the coroutine back on the ready queue of its own
+  // scheduler.
+  fast2.suspend();
+  fastScheduler.runCoroutinePass();
+  assertEqual(3, fast1.calls);
+  assertEqual(2, fast2.calls);
+
+  fast2.resume();
+  slowScheduler.runCoroutinePass();
+  TestableCoroutineScheduler::loop();
+  assertEqual(2, fast2.calls);
+  fastScheduler.runCoroutinePass();
+  assertEqual(4, fast1.calls);
+  assertEqual(3, fast2.calls);
+}
+
+test(MultiSchedulerTest, joinAcrossSchedulersIsPolled) {
+  // The joiner is not parked on the queue of joiners of another scheduler, so
+  // it is resumed on each pass of its own scheduler.
+  joinScheduler.runCoroutinePass();
+  slowScheduler.runCoroutinePass();
+  joinScheduler.runCoroutinePass();
+  assertEqual(2, joiner.calls);
+  assertTrue(joiner.isYielding());
+
+  childMayEnd = true;
+  slowScheduler.runCoroutinePass();
+  assertTrue(child.isDone());
+  joinScheduler.runCoroutinePass();
+  assertEqual(3, joiner.calls);
+  assertTrue(joiner.isDone());
+}
+
+test(MultiSchedulerTest, eventIsDrainedByItsOwnScheduler) {
+  // The waiter parks on the event, which now belongs to its scheduler.
+  eventScheduler.runCoroutinePass();
+  event.notify();
+
+  // Another scheduler does not touch the event.
+  emptyScheduler.runCoroutinePass();
+  assertTrue(event.isPending());
+  assertEqual(0, eventWaiter.received);
+
+  eventScheduler.runCoroutinePass();
+  assertFalse(event.isPending());
+  assertEqual(1, eventWaiter.received);
+}
+
+// Schedulers in separate threads are available only on a Linux or MacOS host.
+#if defined(EPOXY_DUINO)
+
+#include <thread>
+
+const uint16_t NUM_PINGS = 1000;
+
+class Pipeline;
+
+// Notifies the event of the pipeline NUM_PINGS times, waiting each time until
+// the ponger has received the notification.
+class Pinger : public TestableCoroutine {
+  public:
+    explicit Pinger(Pipeline& pipeline) : pipeline(pipeline) {}
+    int runCoroutine() override;
+
+    Pipeline& pipeline;
+    uint16_t pings = 0;
+};
+
+// Receives NUM_PINGS notifications of the event of the pipeline.
+class Ponger : public TestableCoroutine {
+  public:
+    explicit Ponger(Pipeline& pipeline) : pipeline(pipeline) {}
+    int runCoroutine() override;
+
+    Pipeline& pipeline;
+    uint16_t received = 0;
+};
+
+// Joins the ponger.
+class Finisher : public TestableCoroutine {
+  public:
+    explicit Finisher(Pipeline& pipeline) : pipeline(pipeline) {}
+    int runCoroutine() override;
+
+    Pipeline& pipeline;
+};
+
+// A scheduler with its own coroutines and event, run by its own thread.
+class Pipeline {
+  public:
+    Pipeline() : pinger(*this), ponger(*this), finisher(*this) {}
+
+    void setup() {
+      scheduler.addCoroutine(pinger);
+      scheduler.addCoroutine(ponger);
+      scheduler.addCoroutine(finisher);
+      scheduler.setupScheduler();
+    }
+
+    void run() {
+      while (! finisher.isDone()) scheduler.runCoroutinePass();
+    }
+
+    EventTemplate<TestableCoroutine> event;
+    Pinger pinger;
+    Ponger ponger;
+    Finisher finisher;
+    TestableCoroutineScheduler scheduler;
+};
+
+int Pinger::runCoroutine() {
+  COROUTINE_BEGIN();
+  for (pings = 0; pings < NUM_PINGS; pings++) {
+    pipeline.event.notify();
+    COROUTINE_AWAIT(pipeline.ponger.received > pings);
+  }
+  COROUTINE_END();
+}
+
+int Ponger::runCoroutine() {
+  COROUTINE_BEGIN();
+  while (received < NUM_PINGS) {
+    COROUTINE_WAIT_EVENT(pipeline.event);
+    received++;
+  }
+  COROUTINE_END();
+}
+
+int Finisher::runCoroutine() {
+  COROUTINE_BEGIN();
+  COROUTINE_JOIN(pipeline.ponger);
+  COROUTINE_END();
+}
+
+Pipeline pipeline1;
+Pipeline pipeline2;
+
+test(MultiSchedulerTest, schedulersInSeparateThreads) {
+  // Each scheduler parks its coroutines on its own events and joiners, so the
+  // 2 threads share no state.
+  std::thread thread1([] { pipeline1.run(); });
+  std::thread thread2([] { pipeline2.run(); });
+  thread1.join();
+  thread2.join();
+
+  assertEqual(NUM_PINGS, pipeline1.ponger.received);
+  assertEqual(NUM_PINGS, pipeline2.ponger.received);
+  assertTrue(pipeline1.pinger.isDone());
+  assertTrue(pipeline2.pinger.isDone());
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  fastScheduler.addCoroutine(fast1);
+  fastScheduler.addCoroutine(fast2);
+  slowScheduler.addCoroutine(slow);
+  slowScheduler.addCoroutine(child);
+  joinScheduler.addCoroutine(joiner);
+  eventScheduler.addCoroutine(eventWaiter);
+#if defined(EPOXY_DUINO)
+  pipeline1.setup();
+  pipeline2.setup();
+#endif
+
+  TestableCoroutineScheduler::setup();
+  fastScheduler.setupScheduler();
+  slowScheduler.setupScheduler();
+  joinScheduler.setupScheduler();
+  eventScheduler.setupScheduler();
+  emptyScheduler.setupScheduler();
+}
+
+void loop() {
+  TestRunner::run();
+}
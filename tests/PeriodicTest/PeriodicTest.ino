@@ -0,0 +1,199 @@
+#line 2 "PeriodicTest.ino"
+
+// Must be defined before any AceRoutine header.
+#define ACE_ROUTINE_OVERRUN_COUNT 1
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+// ---------------------------------------------------------------------------
+
+class Sampler : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        samples++;
+        COROUTINE_EVERY(10);
+      }
+    }
+
+    uint16_t samples = 0;
+};
+
+class Waiter : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      COROUTINE_DELAY_UNTIL(150);
+      step = 1;
+      COROUTINE_DELAY_UNTIL(50); // already passed
+      step = 2;
+      COROUTINE_END();
+    }
+
+    uint8_t step = 0;
+};
+
+// Yields once, or delays 'delayMillis' if it is not 0, then ends.
+class Step : public SubCoroutineTemplate<TestableCoroutine> {
+  public:
+    explicit Step(uint16_t delayMillis) : delayMillis(delayMillis) {}
+
+    int runCoroutine() override {
+      COROUTINE_BEGIN();
+      if (delayMillis == 0) {
+        COROUTINE_YIELD();
+      } else {
+        COROUTINE_DELAY(delayMillis);
+      }
+      COROUTINE_END();
+    }
+
+    uint16_t const delayMillis;
+};
+
+// Calls the child at the start of each period.
+class CallingSampler : public TestableCoroutine {
+  public:
+    explicit CallingSampler(Step& child) : child(child) {}
+
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        samples++;
+        COROUTINE_CALL(child);
+        COROUTINE_EVERY(10);
+      }
+    }
+
+    Step& child;
+    uint16_t samples = 0;
+};
+
+Sampler sampler;
+Waiter waiter;
+Step yieldingStep(0);
+Step delayingStep(5);
+CallingSampler yieldingCaller(yieldingStep);
+CallingSampler delayingCaller(delayingStep);
+
+// Run the coroutine directly at the given millis.
+static void runAt(TestableCoroutine& coroutine, unsigned long millis) {
+  TestableClockInterface::setMillis(millis);
+  coroutine.runCoroutine();
+}
+
+test(PeriodicTest, everyDoesNotDrift) {
+  runAt(sampler, 0);
+  assertEqual(1, sampler.samples);
+  runAt(sampler, 7);
+  assertEqual(1, sampler.samples);
+
+  // Running 2 millis late does not move the next wakeup from 20.
+  runAt(sampler, 12);
+  assertEqual(2, sampler.samples);
+  runAt(sampler, 19);
+  assertEqual(2, sampler.samples);
+  runAt(sampler, 20);
+  assertEqual(3, sampler.samples);
+  assertEqual(0, sampler.getOverrunCount());
+
+  // Waking up at 55 misses the periods at 40 and 50. They are skipped and
+  // counted, and the next wakeup stays in phase at 60.
+  runAt(sampler, 55);
+  assertEqual(4, sampler.samples);
+  assertEqual(2, sampler.getOverrunCount());
+  runAt(sampler, 59);
+  assertEqual(4, sampler.samples);
+  runAt(sampler, 60);
+  assertEqual(5, sampler.samples);
+
+  // reset() restarts the period from the current time.
+  sampler.reset();
+  sampler.clearOverrunCount();
+  runAt(sampler, 1003);
+  assertEqual(6, sampler.samples);
+  runAt(sampler, 1012);
+  assertEqual(6, sampler.samples);
+  runAt(sampler, 1013);
+  assertEqual(7, sampler.samples);
+  assertEqual(0, sampler.getOverrunCount());
+}
+
+test(PeriodicTest, everyIsKeptAcrossYieldingCall) {
+  runAt(yieldingCaller, 0);
+  assertEqual(1, yieldingCaller.samples);
+  assertTrue(yieldingCaller.isYielding());
+  runAt(yieldingCaller, 1);
+
+  // The period started at 1, when the first call ended.
+  runAt(yieldingCaller, 11);
+  assertEqual(2, yieldingCaller.samples);
+
+  // The call ends 2 millis late, but the next wakeup stays at 21.
+  runAt(yieldingCaller, 13);
+  runAt(yieldingCaller, 20);
+  assertEqual(2, yieldingCaller.samples);
+  runAt(yieldingCaller, 21);
+  assertEqual(3, yieldingCaller.samples);
+}
+
+test(PeriodicTest, everyIsKeptAcrossDelayingCall) {
+  runAt(delayingCaller, 0);
+  assertEqual(1, delayingCaller.samples);
+
+  // Without ACE_ROUTINE_DIRECT_CALLS, the caller yields while its child
+  // polls its own delay.
+  assertTrue(delayingCaller.isYielding());
+  runAt(delayingCaller, 4);
+  assertTrue(delayingCaller.isYielding());
+  runAt(delayingCaller, 5);
+
+  // The period started at 5. The call started at 15 ends at 20, but the
+  // next wakeup stays at 25.
+  runAt(delayingCaller, 15);
+  assertEqual(2, delayingCaller.samples);
+  runAt(delayingCaller, 19);
+  assertTrue(delayingCaller.isYielding());
+  runAt(delayingCaller, 20);
+  runAt(delayingCaller, 24);
+  assertEqual(2, delayingCaller.samples);
+  runAt(delayingCaller, 25);
+  assertEqual(3, delayingCaller.samples);
+}
+
+test(PeriodicTest, delayUntil) {
+  runAt(waiter, 100);
+  assertEqual(0, waiter.step);
+  assertTrue(waiter.isDelaying());
+  runAt(waiter, 149);
+  assertEqual(0, waiter.step);
+
+  // The second delay is in the past, so it only yields.
+  runAt(waiter, 150);
+  assertEqual(1, waiter.step);
+  runAt(waiter, 150);
+  assertEqual(2, waiter.step);
+  assertTrue(waiter.isEnding());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
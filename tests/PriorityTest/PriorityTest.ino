@@ -0,0 +1,128 @@
+#line 2 "PriorityTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Each coroutine counts the number of times that runCoroutine() is called.
+
+class Yielder : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_YIELD();
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+class Sleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(10);
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+Yielder low1;
+Yielder low2;
+Yielder mid;
+Sleeper high;
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+test(PriorityTest, higherPriorityRunsFirst) {
+  // The high priority sleeper runs first, even though it was constructed last
+  // and is therefore at the end of the list of coroutines.
+  loopTimes(1);
+  assertEqual(1, high.calls);
+  assertEqual(0, low1.calls);
+  assertEqual(0, low2.calls);
+  assertTrue(high.isDelaying());
+
+  // While its delay has not expired, the sleeper is skipped without calling
+  // runCoroutine(), and the low priority coroutines run in round-robin order.
+  loopTimes(10);
+  assertEqual(1, high.calls);
+  assertEqual(5, low1.calls);
+  assertEqual(5, low2.calls);
+
+  // As soon as the delay expires, the sleeper runs on the next iteration.
+  TestableClockInterface::setMillis(10);
+  loopTimes(1);
+  assertEqual(2, high.calls);
+  assertEqual(5, low1.calls);
+  assertEqual(5, low2.calls);
+}
+
+test(PriorityTest, higherPriorityYielderStarvesLower) {
+  uint16_t lowCalls = low1.calls + low2.calls;
+
+  // A ready coroutine of a middle priority runs on every iteration.
+  mid.resume();
+  loopTimes(10);
+  assertEqual(10, mid.calls);
+  assertEqual(lowCalls, low1.calls + low2.calls);
+
+  // Except when the higher priority sleeper wakes up.
+  TestableClockInterface::setMillis(20);
+  loopTimes(10);
+  assertEqual(3, high.calls);
+  assertEqual(19, mid.calls);
+  assertEqual(lowCalls, low1.calls + low2.calls);
+
+  // Suspending the middle priority lets the lowest priority run again.
+  mid.suspend();
+  loopTimes(10);
+  assertEqual(19, mid.calls);
+  assertEqual(lowCalls + 10, low1.calls + low2.calls);
+}
+
+test(PriorityTest, setPriorityIsClamped) {
+  assertEqual(TestableCoroutine::kPriorityLowest, low2.getPriority());
+  low2.setPriority(200);
+  assertEqual(TestableCoroutine::kPriorityHighest, low2.getPriority());
+  low2.setPriority(TestableCoroutine::kPriorityLowest);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  mid.setPriority(1);
+  mid.suspend();
+  high.setPriority(2);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -4,6 +4,7 @@
 #include <AceRoutine.h>
 #include <AUnitVerbose.h>
 #include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
 
 using namespace ace_routine;
 using namespace ace_routine::testing;
@@ -82,6 +83,31 @@ test(ResetTest, reset) {
   assertTrue(resettableCoroutine.isYielding());
 }
 
+// Verify that reset() puts a Terminated coroutine back on the ready queue of
+// the scheduler.
+test(ResetTest, resetAfterTerminated) {
+  resettableCoroutine.restart();
+  TestableCoroutineScheduler::setup();
+  assertTrue(resettableCoroutine.isQueued());
+
+  // 6 iterations to reach COROUTINE_END(), 1 more to terminate.
+  for (int i = 0; i < 7; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+  assertEqual(5, resettableCoroutine.count);
+  assertTrue(resettableCoroutine.isTerminated());
+  assertFalse(resettableCoroutine.isQueued());
+
+  resettableCoroutine.restart();
+  assertTrue(resettableCoroutine.isYielding());
+  assertTrue(resettableCoroutine.isQueued());
+
+  TestableCoroutineScheduler::loop();
+  TestableCoroutineScheduler::loop();
+  assertEqual(1, resettableCoroutine.count);
+  assertTrue(resettableCoroutine.isYielding());
+}
+
 // ---------------------------------------------------------------------------
 
 void setup() {
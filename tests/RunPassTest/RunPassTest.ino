@@ -0,0 +1,124 @@
+#line 2 "RunPassTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Each coroutine counts the number of times that it resumed, and advances the
+// micros clock by 10 to simulate the time taken by its work.
+class Worker : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        calls++;
+        TestableClockInterface::setMicros(
+            TestableClockInterface::micros() + 10);
+        COROUTINE_YIELD();
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+class Sleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        calls++;
+        COROUTINE_DELAY(10);
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+Worker worker1;
+Worker worker2;
+Worker worker3;
+Sleeper sleeper;
+
+TimerWheelTemplate<TestableCoroutine, 8> timerWheel;
+
+test(RunPassTest, runPass) {
+  // The order of the tests is not defined, so the counters are compared
+  // relative to their values at the start of this test. Expire the delay of
+  // the sleeper, in case it already ran.
+  uint16_t calls1 = worker1.calls;
+  uint16_t calls2 = worker2.calls;
+  uint16_t calls3 = worker3.calls;
+  uint16_t sleeperCalls = sleeper.calls;
+  TestableClockInterface::setMillis(TestableClockInterface::millis() + 10);
+
+  // Each ready coroutine runs exactly once per pass.
+  TestableCoroutineScheduler::runPass();
+  assertEqual(calls1 + 1, worker1.calls);
+  assertEqual(calls2 + 1, worker2.calls);
+  assertEqual(calls3 + 1, worker3.calls);
+  assertEqual(sleeperCalls + 1, sleeper.calls);
+
+  // The sleeper is in the wheel, so a pass runs only the workers.
+  TestableCoroutineScheduler::runPass();
+  assertEqual(calls1 + 2, worker1.calls);
+  assertEqual(calls2 + 2, worker2.calls);
+  assertEqual(calls3 + 2, worker3.calls);
+  assertEqual(sleeperCalls + 1, sleeper.calls);
+
+  // A suspended coroutine is not part of the pass.
+  worker2.suspend();
+  TestableCoroutineScheduler::runPass();
+  assertEqual(calls1 + 3, worker1.calls);
+  assertEqual(calls2 + 2, worker2.calls);
+  assertEqual(calls3 + 3, worker3.calls);
+
+  // The sleeper joins the pass after its delay expires.
+  TestableClockInterface::setMillis(TestableClockInterface::millis() + 10);
+  TestableCoroutineScheduler::runPass();
+  assertEqual(calls1 + 4, worker1.calls);
+  assertEqual(calls3 + 4, worker3.calls);
+  assertEqual(sleeperCalls + 2, sleeper.calls);
+
+  worker2.resume();
+}
+
+test(RunPassTest, runFor) {
+  uint16_t calls = worker1.calls + worker2.calls + worker3.calls;
+
+  // Each pass runs 3 workers using 10 micros each, so a budget of 90 micros
+  // runs 3 passes.
+  TestableCoroutineScheduler::runFor(90);
+  assertEqual(calls + 9, worker1.calls + worker2.calls + worker3.calls);
+
+  // The budget is checked after each pass, so the last pass overruns.
+  TestableCoroutineScheduler::runFor(65);
+  assertEqual(calls + 18, worker1.calls + worker2.calls + worker3.calls);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+  TestableCoroutineScheduler::setTimerWheel(&timerWheel);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,144 @@
+#line 2 "SchedulerStatsTest.ino"
+
+// Must be defined before any AceRoutine header.
+#define ACE_ROUTINE_SCHEDULER_STATS 1
+
+#include <AceRoutine.h>
+#include <AceCommon.h> // PrintStr
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_common::PrintStr;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+class Sleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(100);
+      }
+    }
+};
+
+class Yielder : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      COROUTINE_LOOP() {
+        COROUTINE_YIELD();
+      }
+    }
+};
+
+Sleeper sleeper;
+Yielder yielder;
+
+// Pretends to sleep for 500 micros.
+static void idleHook(uint32_t /*micros*/) {
+  TestableClockInterface::setMicros(TestableClockInterface::micros() + 500);
+}
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+// The order of the tests is not defined, so each test starts from a known
+// state.
+static void resetState() {
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setMicros(0);
+  sleeper.reset();
+  yielder.reset();
+  TestableCoroutineScheduler::setup();
+  TestableCoroutineScheduler::clearStats();
+}
+
+test(SchedulerStatsTest, countPassesAndDispatches) {
+  resetState();
+  const SchedulerStats& stats = TestableCoroutineScheduler::getStats();
+
+  // The coroutines run alternately. The sleeper does work only on its first
+  // run, then only checks its delay.
+  loopTimes(10);
+  assertEqual((uint32_t) 10, stats.getNumPasses());
+  assertEqual((uint32_t) 0, stats.getNumEmptyPasses());
+  assertEqual((uint32_t) 10, stats.getNumDispatches());
+  assertEqual((uint32_t) 4, stats.getNumDelayChecks());
+  assertEqual((uint32_t) 1, sleeper.getRunCount());
+  assertEqual((uint32_t) 5, yielder.getRunCount());
+
+  // One runPass() is one pass, which dispatches both coroutines.
+  TestableClockInterface::setMillis(100);
+  TestableCoroutineScheduler::runPass();
+  assertEqual((uint32_t) 11, stats.getNumPasses());
+  assertEqual((uint32_t) 12, stats.getNumDispatches());
+  assertEqual((uint32_t) 2, sleeper.getRunCount());
+  assertEqual((uint32_t) 6, yielder.getRunCount());
+
+  // A pass with nothing to run, then the idle hook.
+  sleeper.suspend();
+  yielder.suspend();
+  TestableCoroutineScheduler::setIdleHook(idleHook);
+  TestableCoroutineScheduler::loopUntilIdle();
+  TestableCoroutineScheduler::setIdleHook(nullptr);
+  assertEqual((uint32_t) 12, stats.getNumPasses());
+  assertEqual((uint32_t) 1, stats.getNumEmptyPasses());
+  assertEqual((uint32_t) 500, stats.getIdleMicros());
+
+  TestableCoroutineScheduler::clearStats();
+  assertEqual((uint32_t) 0, stats.getNumPasses());
+  assertEqual((uint32_t) 0, sleeper.getRunCount());
+  assertEqual((uint32_t) 0, yielder.getRunCount());
+}
+
+test(SchedulerStatsTest, renderer) {
+  resetState();
+  sleeper.setName("sleeper");
+  yielder.setName("yielder");
+
+  loopTimes(10);
+  TestableClockInterface::setMicros(2000000);
+
+  PrintStr<300> output;
+  SchedulerStatsRendererTemplate<TestableCoroutine>::printTo(output);
+  assertEqual(
+    "elapsed(ms)     passes  passes/s  dispatch"
+        " checks(%)  empty(%)   idle(%)\r\n"
+    "        2000        10         5        10"
+        "        40         0         0\r\n"
+    "name              runs    runs/s\r\n"
+    "yielder              5         2\r\n"
+    "sleeper              1         0\r\n",
+    output.cstr()
+  );
+
+  // The stats were cleared.
+  assertEqual((uint32_t) 0, TestableCoroutineScheduler::getStats()
+      .getNumPasses());
+  assertEqual((uint32_t) 0, yielder.getRunCount());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
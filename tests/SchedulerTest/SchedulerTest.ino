@@ -112,13 +112,8 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isDelaying());
   assertTrue(extra.isSuspended());
 
-  // skip extra
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isYielding());
-  assertTrue(c.isDelaying());
-  assertTrue(extra.isSuspended());
-
+  // 'extra' is suspended, so it is not on the ready queue, and the next
+  // iteration goes back to 'a'.
   TestableClockInterface::setMillis(10);
 
   // run a
@@ -142,13 +137,6 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isDelaying());
   assertTrue(extra.isSuspended());
 
-  // skip extra
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isDelaying());
-  assertTrue(c.isDelaying());
-  assertTrue(extra.isSuspended());
-
   TestableClockInterface::setMillis(36);
 
   // run a
@@ -172,13 +160,6 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isDelaying());
   assertTrue(extra.isSuspended());
 
-  // run c
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isYielding());
-  assertTrue(c.isDelaying());
-  assertTrue(extra.isSuspended());
-
   TestableClockInterface::setMillis(101);
 
   // run a
@@ -202,13 +183,6 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isEnding());
   assertTrue(extra.isSuspended());
 
-  // run extra
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isYielding());
-  assertTrue(c.isEnding());
-  assertTrue(extra.isSuspended());
-
   TestableClockInterface::setMillis(102);
 
   // run a
@@ -225,14 +199,7 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isEnding());
   assertTrue(extra.isSuspended());
 
-  // run c - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isEnding());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run extra - suspended
+  // run c - terminated, and removed from the ready queue
   TestableCoroutineScheduler::loop();
   assertTrue(a.isYielding());
   assertTrue(b.isEnding());
@@ -241,58 +208,31 @@ test(AceRoutineTest, scheduler) {
 
   TestableClockInterface::setMillis(103);
 
-  // run a, waiting for b over
+  // run a, b is done, so a loops around to COROUTINE_DELAY()
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isEnding());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  // run b - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run c - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run extra - suspended
+  // run b - terminated, and removed from the ready queue
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
+  // Only 'a' is left on the ready queue, so every iteration runs 'a'.
   TestableClockInterface::setMillis(104);
 
-  // run a - hits COROUTINE_DELAY(25)
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run b - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run c - terminated
+  // run a - still delaying
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  // run extra - suspended
+  // run a - still delaying
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
@@ -309,31 +249,10 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isTerminated());
   assertTrue(extra.isSuspended());
 
-  // run b - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run c - terminated
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
-  // run extra - suspended
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isSuspended());
-
   // step 1 millis
   TestableClockInterface::setMillis(131);
 
-  // resume 'extra'
+  // resume 'extra', which puts it at the back of the ready queue
   assertTrue(extra.isSuspended());
   extra.resume();
 
@@ -344,20 +263,6 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isTerminated());
   assertTrue(extra.isYielding());
 
-  // run b
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isYielding());
-
-  // run c
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isDelaying());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isYielding());
-
   // run extra
   TestableCoroutineScheduler::loop();
   assertTrue(a.isDelaying());
@@ -375,23 +280,16 @@ test(AceRoutineTest, scheduler) {
   assertTrue(c.isTerminated());
   assertTrue(extra.isEnding());
 
-  // run b
+  // run extra - terminated
   TestableCoroutineScheduler::loop();
   assertTrue(a.isYielding());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
-  assertTrue(extra.isEnding());
-
-  // run c
-  TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
-  assertTrue(b.isTerminated());
-  assertTrue(c.isTerminated());
-  assertTrue(extra.isEnding());
+  assertTrue(extra.isTerminated());
 
-  // run extra
+  // run a, hits COROUTINE_DELAY()
   TestableCoroutineScheduler::loop();
-  assertTrue(a.isYielding());
+  assertTrue(a.isDelaying());
   assertTrue(b.isTerminated());
   assertTrue(c.isTerminated());
   assertTrue(extra.isTerminated());
@@ -408,7 +306,8 @@ void setup() {
   while (!Serial); // Leonardo/Micro
 
   // Start the 'extra' coroutine in suspended state. Starting v1.2, a
-  // suspended coroutine will be retained in the linked list of coroutines.
+  // suspended coroutine will be retained in the linked list of coroutines, but
+  // it is not placed on the ready queue of the scheduler.
   extra.suspend();
 
   // Set human-readable names to some coroutines.
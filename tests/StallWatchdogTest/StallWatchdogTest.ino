@@ -0,0 +1,111 @@
+#line 2 "StallWatchdogTest.ino"
+
+#include <AceRoutine.h>
+#include <AceCommon.h> // PrintStr
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_common::PrintStr;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Pretends to run for 'busyMicros' on each call to runCoroutine().
+class Busy : public TestableCoroutine {
+  public:
+    explicit Busy(uint32_t busyMicros) : busyMicros(busyMicros) {}
+
+    int runCoroutine() override {
+      TestableClockInterface::setMicros(
+          TestableClockInterface::micros() + busyMicros);
+      COROUTINE_LOOP() {
+        COROUTINE_YIELD();
+      }
+    }
+
+    uint32_t busyMicros;
+};
+
+Busy fast(100);
+Busy slow(5000);
+
+using Watchdog = StallWatchdogTemplate<TestableCoroutine, 1>;
+
+TestableCoroutine* lastOffender = nullptr;
+uint32_t lastElapsed = 0;
+
+static void onStall(TestableCoroutine* coroutine, uint32_t elapsedMicros) {
+  lastOffender = coroutine;
+  lastElapsed = elapsedMicros;
+}
+
+Watchdog watchdog(1000, onStall);
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+test(StallWatchdogTest, recordsOffenders) {
+  watchdog.clear();
+  lastOffender = nullptr;
+  TestableCoroutineScheduler::setStallWatchdog(&watchdog);
+
+  // Each coroutine runs twice. Only 'slow' exceeds the threshold.
+  loopTimes(4);
+  assertEqual(1, watchdog.getNumRecords());
+  const Watchdog::Record& record = watchdog.getRecord(0);
+  assertTrue(record.coroutine == &slow);
+  assertEqual((uint32_t) 2, record.count);
+  assertEqual((uint32_t) 5000, record.lastMicros);
+  assertEqual((uint32_t) 5000, record.worstMicros);
+  assertTrue(lastOffender == &slow);
+  assertEqual((uint32_t) 5000, lastElapsed);
+
+  // The table has room for 1 coroutine, so the stalls of 'fast' are only
+  // counted.
+  fast.busyMicros = 2000;
+  loopTimes(4);
+  assertEqual(1, watchdog.getNumRecords());
+  assertEqual((uint32_t) 4, watchdog.getRecord(0).count);
+  assertEqual((uint32_t) 2, watchdog.getNumDropped());
+  fast.busyMicros = 100;
+
+  slow.setName("slow");
+  PrintStr<150> output;
+  watchdog.printTo(output);
+  assertEqual(
+    "name             count  last(us) worst(us)\r\n"
+    "slow                 4      5000      5000\r\n"
+    "dropped              2\r\n",
+    output.cstr()
+  );
+
+  TestableCoroutineScheduler::setStallWatchdog(nullptr);
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMicros(0);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}
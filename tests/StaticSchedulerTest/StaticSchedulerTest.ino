@@ -0,0 +1,103 @@
+#line 2 "StaticSchedulerTest.ino"
+
+#include <AceRoutine.h>
+#include <AceCommon.h> // PrintStr
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_common::PrintStr;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+
+// ---------------------------------------------------------------------------
+
+// Records the order in which the coroutines run.
+PrintStr<16> order;
+
+class Yielder : public TestableCoroutine {
+  public:
+    explicit Yielder(char id) : id(id) {}
+
+    int runCoroutine() override {
+      order.print(id);
+      COROUTINE_LOOP() {
+        COROUTINE_YIELD();
+      }
+    }
+
+    void setupCoroutine() override {
+      setupCalled = true;
+    }
+
+    char const id;
+    bool setupCalled = false;
+};
+
+class Finisher : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      order.print('f');
+      COROUTINE_BEGIN();
+      COROUTINE_YIELD();
+      COROUTINE_END();
+    }
+};
+
+Yielder a('a');
+Yielder b('b');
+Finisher f;
+
+// The coroutines run in the order of the template arguments, independent of
+// the order of the linked list.
+using Scheduler = StaticCoroutineScheduler<
+    STATIC_COROUTINE(b),
+    STATIC_COROUTINE(f),
+    STATIC_COROUTINE(a)
+>;
+
+test(StaticSchedulerTest, runsInDeclaredOrder) {
+  assertEqual(3, Scheduler::kNumCoroutines);
+
+  Scheduler::setupCoroutines();
+  assertTrue(a.setupCalled);
+  assertTrue(b.setupCalled);
+
+  // 'f' yields once, ends, then is terminated by the scheduler and skipped.
+  order.flush();
+  Scheduler::loop();
+  assertEqual("bfa", order.cstr());
+  Scheduler::loop();
+  assertEqual("bfabfa", order.cstr());
+  assertTrue(f.isEnding());
+  Scheduler::loop();
+  assertTrue(f.isTerminated());
+  Scheduler::loop();
+  assertEqual("bfabfababa", order.cstr());
+
+  // Suspended coroutines are skipped.
+  order.flush();
+  b.suspend();
+  Scheduler::loop();
+  assertEqual("a", order.cstr());
+  b.resume();
+  Scheduler::loop();
+  assertEqual("aba", order.cstr());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
@@ -0,0 +1,134 @@
+#line 2 "ThreadedSchedulerTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+
+using namespace aunit;
+using namespace ace_routine;
+
+// ThreadedCoroutineScheduler is available only on a Linux or MacOS host.
+#if defined(EPOXY_DUINO)
+
+#include <atomic>
+#include <ace_routine/ThreadedCoroutineScheduler.h>
+
+// ---------------------------------------------------------------------------
+
+const uint16_t NUM_COROUTINES = 100;
+const uint16_t NUM_STEPS = 200;
+
+// Number of times that a coroutine was found running on 2 threads at once.
+std::atomic<uint32_t> overlaps{0};
+
+// Each coroutine yields NUM_STEPS times, then terminates. It detects whether
+// another thread is running it at the same time.
+class Stepper : public Coroutine {
+  public:
+    int runCoroutine() override {
+      if (running.fetch_add(1) != 0) overlaps++;
+      COROUTINE_BEGIN();
+      for (steps = 0; steps < NUM_STEPS; steps++) {
+        running--;
+        COROUTINE_YIELD();
+        // A yield returns from runCoroutine(), so 'running' is incremented
+        // again at the top when the coroutine resumes.
+      }
+      running--;
+      COROUTINE_END();
+    }
+
+    std::atomic<uint8_t> running{0};
+    uint16_t steps = 0;
+};
+
+test(ThreadedSchedulerTest, runsEveryCoroutineToCompletion) {
+  Stepper* steppers = new Stepper[NUM_COROUTINES];
+  ThreadedCoroutineScheduler scheduler(4);
+  assertEqual(4, scheduler.getNumThreads());
+  for (uint16_t i = 0; i < NUM_COROUTINES; i++) {
+    scheduler.addCoroutine(steppers[i]);
+  }
+
+  scheduler.start();
+  scheduler.waitUntilTerminated();
+
+  assertEqual((uint32_t) 0, scheduler.getNumLive());
+  assertEqual((uint32_t) 0, overlaps.load());
+  for (uint16_t i = 0; i < NUM_COROUTINES; i++) {
+    assertEqual(NUM_STEPS, steppers[i].steps);
+    assertTrue(steppers[i].isTerminated());
+  }
+}
+
+const uint16_t NUM_SLEEPERS = 20;
+const uint8_t NUM_DELAYS = 5;
+
+// Each coroutine delays NUM_DELAYS times, then terminates. It counts how many
+// times it is called.
+class Sleeper : public Coroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_BEGIN();
+      for (delays = 0; delays < NUM_DELAYS; delays++) {
+        COROUTINE_DELAY(10);
+      }
+      COROUTINE_END();
+    }
+
+    std::atomic<uint32_t> calls{0};
+    uint8_t delays = 0;
+};
+
+test(ThreadedSchedulerTest, delayingCoroutinesAreNotPolled) {
+  Sleeper* sleepers = new Sleeper[NUM_SLEEPERS];
+  ThreadedCoroutineScheduler scheduler(4);
+  for (uint16_t i = 0; i < NUM_SLEEPERS; i++) {
+    scheduler.addCoroutine(sleepers[i]);
+  }
+
+  unsigned long startMillis = millis();
+  scheduler.start();
+  scheduler.waitUntilTerminated();
+  unsigned long elapsedMillis = millis() - startMillis;
+
+  assertMoreOrEqual(elapsedMillis, (unsigned long) NUM_DELAYS * 10);
+  for (uint16_t i = 0; i < NUM_SLEEPERS; i++) {
+    assertTrue(sleepers[i].isTerminated());
+    // Called once at the start, then once when each delay expired.
+    assertEqual((uint32_t) NUM_DELAYS + 1, sleepers[i].calls.load());
+  }
+}
+
+test(ThreadedSchedulerTest, suspendedCoroutineIsSetAside) {
+  Sleeper* sleepers = new Sleeper[2];
+  ThreadedCoroutineScheduler scheduler(2);
+  scheduler.addCoroutine(sleepers[0]);
+  scheduler.addCoroutine(sleepers[1]);
+  sleepers[1].suspend();
+
+  scheduler.start();
+  scheduler.waitUntilTerminated();
+
+  assertEqual((uint32_t) 0, scheduler.getNumLive());
+  assertTrue(sleepers[0].isTerminated());
+  assertTrue(sleepers[1].isSuspended());
+  assertEqual((uint32_t) 0, sleepers[1].calls.load());
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+}
+
+void loop() {
+  TestRunner::run();
+}
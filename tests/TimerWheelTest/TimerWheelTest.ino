@@ -0,0 +1,208 @@
+#line 2 "TimerWheelTest.ino"
+
+#include <AceRoutine.h>
+#include <AUnitVerbose.h>
+#include "ace_routine/testing/TestableCoroutine.h"
+#include "ace_routine/testing/TestableCoroutineScheduler.h"
+#include "ace_routine/testing/TestableClockInterface.h"
+
+using namespace aunit;
+using namespace ace_routine;
+using ace_routine::testing::TestableClockInterface;
+using ace_routine::testing::TestableCoroutine;
+using ace_routine::testing::TestableCoroutineScheduler;
+
+// ---------------------------------------------------------------------------
+
+// Each coroutine counts the number of times that runCoroutine() is called,
+// including the calls which only find that the delay has not yet expired.
+
+class ShortSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY(100);
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+class LongSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        // Longer than the number of slots, so it goes around the wheel.
+        COROUTINE_DELAY(1000);
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+class SecondsSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY_SECONDS(2);
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+class MicrosSleeper : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_DELAY_MICROS(500);
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+class Yielder : public TestableCoroutine {
+  public:
+    int runCoroutine() override {
+      calls++;
+      COROUTINE_LOOP() {
+        COROUTINE_YIELD();
+      }
+    }
+
+    uint16_t calls = 0;
+};
+
+Yielder yielder;
+MicrosSleeper microsSleeper;
+SecondsSleeper secondsSleeper;
+LongSleeper longSleeper;
+ShortSleeper shortSleeper;
+
+TimerWheelTemplate<TestableCoroutine, 8> timerWheel;
+
+// Run the scheduler 'n' times.
+static void loopTimes(uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    TestableCoroutineScheduler::loop();
+  }
+}
+
+test(TimerWheelTest, delayingCoroutinesAreNotPolled) {
+  // First pass runs every coroutine once. The 3 coroutines delaying in millis
+  // and seconds go into the timer wheel.
+  loopTimes(5);
+  assertEqual(1, shortSleeper.calls);
+  assertEqual(1, longSleeper.calls);
+  assertEqual(1, secondsSleeper.calls);
+  assertEqual(1, microsSleeper.calls);
+  assertEqual(1, yielder.calls);
+  assertTrue(shortSleeper.isDelaying());
+  assertTrue(longSleeper.isDelaying());
+  assertTrue(secondsSleeper.isDelaying());
+
+  // Only the yielder and the micros sleeper are left on the ready queue.
+  loopTimes(10);
+  assertEqual(1, shortSleeper.calls);
+  assertEqual(1, longSleeper.calls);
+  assertEqual(1, secondsSleeper.calls);
+  assertEqual(6, microsSleeper.calls);
+  assertEqual(6, yielder.calls);
+
+  // Just before expiration.
+  TestableClockInterface::setMillis(99);
+  loopTimes(10);
+  assertEqual(1, shortSleeper.calls);
+  assertEqual(1, longSleeper.calls);
+  assertEqual(1, secondsSleeper.calls);
+
+  // At expiration, shortSleeper is moved to the ready queue and runs exactly
+  // once, then goes back into the wheel.
+  TestableClockInterface::setMillis(100);
+  loopTimes(10);
+  assertEqual(2, shortSleeper.calls);
+  assertEqual(1, longSleeper.calls);
+  assertEqual(1, secondsSleeper.calls);
+
+  // Advance more than the size of the wheel in one step. Every slot is visited
+  // once, and the longSleeper (1000 millis) is still not expired.
+  TestableClockInterface::setMillis(150);
+  loopTimes(10);
+  assertEqual(2, shortSleeper.calls);
+  assertEqual(1, longSleeper.calls);
+
+  TestableClockInterface::setMillis(200);
+  loopTimes(10);
+  assertEqual(3, shortSleeper.calls);
+  assertEqual(1, longSleeper.calls);
+
+  // Go around the wheel many times, 1 millisecond at a time.
+  for (uint16_t t = 201; t < 1000; t++) {
+    TestableClockInterface::setMillis(t);
+    loopTimes(3);
+  }
+  assertEqual(1, longSleeper.calls);
+  assertEqual(10, shortSleeper.calls);
+
+  TestableClockInterface::setMillis(1000);
+  loopTimes(10);
+  assertEqual(2, longSleeper.calls);
+  assertEqual(11, shortSleeper.calls);
+  assertEqual(1, secondsSleeper.calls);
+
+  // The seconds sleeper wakes up when the seconds clock is 2.
+  TestableClockInterface::setMillis(1999);
+  TestableClockInterface::setSeconds(1);
+  loopTimes(10);
+  assertEqual(1, secondsSleeper.calls);
+
+  TestableClockInterface::setMillis(2000);
+  TestableClockInterface::setSeconds(2);
+  loopTimes(10);
+  assertEqual(2, secondsSleeper.calls);
+}
+
+test(TimerWheelTest, suspendedCoroutineInWheel) {
+  TestableClockInterface::setMillis(3000);
+  loopTimes(10);
+  assertTrue(shortSleeper.isDelaying());
+  uint16_t calls = shortSleeper.calls;
+
+  // Suspending a coroutine removes it from the wheel, so it is not moved to
+  // the ready queue when its delay expires, and the scheduler does not run it.
+  shortSleeper.suspend();
+  TestableClockInterface::setMillis(3200);
+  loopTimes(10);
+  assertEqual(calls, shortSleeper.calls);
+  assertTrue(shortSleeper.isSuspended());
+
+  shortSleeper.resume();
+  loopTimes(10);
+  assertEqual(calls + 1, shortSleeper.calls);
+  assertTrue(shortSleeper.isDelaying());
+}
+
+// ---------------------------------------------------------------------------
+
+void setup() {
+#if defined(ARDUINO)
+  delay(1000); // some boards reboot twice
+#endif
+
+  Serial.begin(115200);
+  while (!Serial); // Leonardo/Micro
+
+  TestableClockInterface::setMillis(0);
+  TestableClockInterface::setSeconds(0);
+  TestableCoroutineScheduler::setTimerWheel(&timerWheel);
+  TestableCoroutineScheduler::setup();
+}
+
+void loop() {
+  TestRunner::run();
+}